@@ -1,4 +1,6 @@
 #include "Agent.h"
+#include "PathCache.h"
+#include "SIPP.h"
 
 struct HeuristicNode {
   HeuristicNode(int loc, Task *task, int h_val)
@@ -21,17 +23,11 @@ Token::Token(const Token &token) {
   tasks.resize(token.tasks.size());
   copy(token.tasks.begin(), token.tasks.end(), tasks.begin());
 
-  agents.resize(token.agents.size());
-  copy(token.agents.begin(), token.agents.end(), agents.begin());
-
-  path.resize(token.path.size());
-  for (int i = 0; i < path.size(); i++) {
-    path[i].resize(token.path[i].size());
-    for (int j = 0; j < token.path[i].size(); j++) {
-      path[i][j] = token.path[i][j];
-    }
-  }
+  ag_loc = token.ag_loc;
+  ag_finish_time = token.ag_finish_time;
+  path = token.path;
   timestep = token.timestep;
+  col = token.col;
 }
 void Token::reset(const Token &token) {
   vector<bool>::const_iterator j = token.my_map.begin();
@@ -44,72 +40,33 @@ void Token::reset(const Token &token) {
     (*i) = (*j2);
   }
 
-  for (int i = 0; i < agents.size(); i++) {
-    agents[i] = token.agents[i];
-  }
-
-  path.resize(token.path.size());
-  for (int i = 0; i < path.size(); i++) {
-    path[i].resize(token.path[i].size());
-    for (int j = 0; j < token.path[i].size(); j++) {
-      path[i][j] = token.path[i][j];
-    }
-  }
+  ag_loc = token.ag_loc;
+  ag_finish_time = token.ag_finish_time;
+  path.reset(token.path);
   timestep = token.timestep;
+  changed.push_back(-1);
 }
 
 // Agent
-Agent::Agent(int loc, int col, int row, int id, int maxtime)
-    : loc(loc), col(col), row(row), id(id), finish_time(0), maxtime(maxtime) {
-  for (int i = 0; i < maxtime; i++) {
-    path.push_back(loc); // hold the initial point
-  }
-};
-Agent::Agent(const Agent &ag) {
-  path.resize(ag.path.size());
-  copy(ag.path.begin(), ag.path.end(), path.begin());
-  loc = ag.loc;
-  id = ag.id;
-  maxtime = ag.maxtime;
-  finish_time = ag.finish_time;
-  task = ag.task;
-  row = ag.row;
-  col = ag.col;
-}
-Agent::~Agent() {}
-
-void Agent::reset(const Agent &ag) {
-  for (int i = 0; i < path.size(); i++) {
-    path[i] = ag.path[i];
-  }
-  loc = ag.loc;
-  id = ag.id;
-  maxtime = ag.maxtime;
-  finish_time = ag.finish_time;
-  task = ag.task;
-  row = ag.row;
-  col = ag.col;
-}
-void Agent::Set(int loc, int col, int row, int id, unsigned int maxtime) {
-  this->loc = loc;
-  this->col = col;
-  this->row = row;
+void Agent::Set(int id, int loc, Token &token) {
   this->id = id;
-  this->finish_time = 0;
-  this->maxtime = maxtime;
-  for (int i = 0; i < maxtime; i++) {
-    path.push_back(loc); // stay still all the tiem
+  path = token.path[id];
+  for (int i = 0; i < path.size(); i++) {
+    path[i] = loc; // stay still all the tiem
   }
+  token.ag_loc[id] = loc;
+  token.ag_finish_time[id] = 0;
 };
 
 bool Agent::TOTP(Token &token, bool verbose) {
   // update agent current location
-  loc = path[token.timestep];
+  int loc = token.ag_loc[id] = path[token.timestep];
 
-  vector<bool> hold(col * row, false);
+  vector<bool> hold(token.my_map.size(), false);
+  const loc_t *last = token.path.at(path.size() - 1);
   for (unsigned int i = 0; i < token.path.size(); i++) {
     if (i != id)
-      hold[token.path[i][maxtime - 1]] = true;
+      hold[last[i]] = true;
   }
   // sort tasks by heuristic distances
 
@@ -152,18 +109,12 @@ bool Agent::TOTP(Token &token, bool verbose) {
       }
     }
     if (move) {
-      if (Move2EP(token)) {
-        for (int i = token.timestep; i < token.path[id].size();
-             i++) // agent move with package or waiting
-        {
-          token.path[id][i] = path[i];
-        }
+      if (Move2EP(token, false))
         return true;
-      }
     } else {
       // std::cout << "Agent " << id << " wait at timestep " << token.timestep
       // << endl;
-      finish_time = token.timestep + 1;
+      token.ag_finish_time[id] = token.timestep + 1;
       return true;
     }
 
@@ -172,45 +123,39 @@ bool Agent::TOTP(Token &token, bool verbose) {
   else // take this task
   {
 
-    int arrive_start = AStar(loc, token.timestep, *task->start, token, id);
+    int arrive_start = FindPath(loc, token.timestep, *task->start, token, id);
     if (arrive_start < 0) {
       if (verbose)
         cerr << "Agent " << id << " can not find a path to start" << endl;
-      this->finish_time = token.timestep + 1;
+      token.ag_finish_time[id] = token.timestep + 1;
       return false;
       // system("PAUSE");
     }
 
     // try to find a path from start to goal
     // if succeed, return the arriving timestep; otherwise, return -1
-    int arrive_goal = AStar(task->start->loc, arrive_start + task->start_time,
-                            *task->goal, token, id);
+    int arrive_goal =
+        FindPath(task->start->loc, arrive_start + task->start_time,
+                 *task->goal, token, id);
     if (arrive_goal < 0) // find a path to goal
     {
       if (verbose)
         cerr << "Agent " << id << " can not find a path to start" << endl;
-      this->finish_time = token.timestep + 1;
+      token.ag_finish_time[id] = token.timestep + 1;
       return false;
       // system("PAUSE");
     }
-    // update token path
-    // positive means deliver package or waiting at goal or home, negative means
-    // moving without package
-    for (int i = token.timestep; i < token.path[id].size();
-         i++) // agent move with package or waiting
-    {
-      token.path[id][i] = path[i];
-    }
     // update agent
-    this->finish_time =
+    token.ag_finish_time[id] =
         arrive_goal + task->goal_time; // next available timestep for agent
 
     // show
     if (verbose) {
       cout << "Agent " << id << " take task " << task->id << " "
-           << task->start->loc % col - 1 << "," << task->start->loc / col - 1
-           << " --> " << task->goal->loc % col - 1 << ","
-           << task->goal->loc / col - 1;
+           << task->start->loc % token.col - 1 << ","
+           << task->start->loc / token.col - 1 << " --> "
+           << task->goal->loc % token.col - 1 << ","
+           << task->goal->loc / token.col - 1;
       cout << "	Timestep " << token.timestep << "-->" << arrive_goal << endl;
     }
 
@@ -232,12 +177,16 @@ bool Agent::TOTP(Token &token, bool verbose) {
   return false;
 }
 bool Agent::TPTR(Token &token, bool verbose) {
-  // a copy of token and agent
-  Token token_copy(token);
-  Agent agent_copy(*this);
+  // save the agent's plan: if it fails, restoring it restores the token, since
+  // the agents it robbed restore their own plans when they fail
+  const unsigned int maxtime = path.size();
+  vector<loc_t> saved_path(maxtime - token.timestep);
+  for (int i = token.timestep; i < maxtime; i++)
+    saved_path[i - token.timestep] = path[i];
+  unsigned int saved_finish_time = token.ag_finish_time[id];
 
   // update agent current location
-  loc = path[token.timestep];
+  int loc = token.ag_loc[id] = path[token.timestep];
 
   // sort tasks by heuristic distances
   boost::heap::fibonacci_heap<HeuristicNode,
@@ -257,28 +206,28 @@ bool Agent::TPTR(Token &token, bool verbose) {
     }
   }
 
-  while (!heuristic.empty()) {
+  while (!heuristic.empty() && !token.chain.OutOfBudget()) {
     // try the task with min heuristic
     HeuristicNode n = heuristic.top();
     heuristic.pop();
 
     if (WAIT == n.task->state // no agent took this task before
         ||
-        (TAKEN == n.task->state &&
+        (TAKEN == n.task->state && token.chain.CanRob() &&
          n.task->ag_arrive_start >
              token.timestep +
                  n.h_val)) // or the agent may arrive before the original agent
     {
       // check whether the start and goal are or will be occupied
       bool occupied = false;
+      const loc_t *last = token.path.at(maxtime - 1);
       for (unsigned int i = 0; i < token.path.size(); i++) {
         if (i == id)
           continue; // ignore the path of agent itself
         else if (TAKEN == n.task->state && i == n.task->ag->id)
           continue; // ignore the path of original agent
-        else if (token.path[i][maxtime - 1] == n.task->goal->loc ||
-                 token.path[i][maxtime - 1] ==
-                     n.task->start->loc) // start or goal is occupied
+        else if (last[i] == n.task->goal->loc ||
+                 last[i] == n.task->start->loc) // start or goal is occupied
         {
           occupied = true;
           break;
@@ -294,10 +243,10 @@ bool Agent::TPTR(Token &token, bool verbose) {
       // if succeed, return the arriving timestep; otherwise, return -1
       int arrive_start;
       if (TAKEN == n.task->state) // try to swap
-        arrive_start =
-            AStar(loc, token.timestep, *n.task->start, token, n.task->ag->id);
+        arrive_start = FindPath(loc, token.timestep, *n.task->start, token,
+                                n.task->ag->id);
       else
-        arrive_start = AStar(loc, token.timestep, *n.task->start, token, id);
+        arrive_start = FindPath(loc, token.timestep, *n.task->start, token, id);
 
       if (0 <= arrive_start &&
           (WAIT == n.task->state ||
@@ -308,22 +257,17 @@ bool Agent::TPTR(Token &token, bool verbose) {
         int arrive_goal;
         if (TAKEN == n.task->state) // try to swap
           arrive_goal =
-              AStar(n.task->start->loc, arrive_start + n.task->start_time,
-                    *n.task->goal, token, n.task->ag->id);
+              FindPath(n.task->start->loc, arrive_start + n.task->start_time,
+                       *n.task->goal, token, n.task->ag->id);
         else
           arrive_goal =
-              AStar(n.task->start->loc, arrive_start + n.task->start_time,
-                    *n.task->goal, token, id);
+              FindPath(n.task->start->loc, arrive_start + n.task->start_time,
+                       *n.task->goal, token, id);
 
         if (arrive_goal >= 0) // find a path to goal
         {
-          // update token path
-          for (int i = token.timestep; i < token.path[id].size(); i++) {
-            token.path[id][i] = path[i];
-          }
-
           // update agent finish_time
-          this->finish_time =
+          token.ag_finish_time[id] =
               arrive_goal +
               n.task->goal_time; // next available timestep for agent
 
@@ -332,10 +276,10 @@ bool Agent::TPTR(Token &token, bool verbose) {
             // show
             if (verbose) {
               cout << "Agent " << id << " take task " << n.task->id << " "
-                   << n.task->start->loc % col - 1 << ","
-                   << n.task->start->loc / col - 1 << " --> "
-                   << n.task->goal->loc % col - 1 << ","
-                   << n.task->goal->loc / col - 1;
+                   << n.task->start->loc % token.col - 1 << ","
+                   << n.task->start->loc / token.col - 1 << " --> "
+                   << n.task->goal->loc % token.col - 1 << ","
+                   << n.task->goal->loc / token.col - 1;
               cout << " at Timestep " << token.timestep << "-->" << arrive_goal
                    << endl;
             }
@@ -354,10 +298,10 @@ bool Agent::TPTR(Token &token, bool verbose) {
             // show
             if (verbose) {
               cout << "Agent " << id << " swaps task " << n.task->id << " "
-                   << n.task->start->loc % col - 1 << ","
-                   << n.task->start->loc / col - 1 << " --> "
-                   << n.task->goal->loc % col - 1 << ","
-                   << n.task->goal->loc / col - 1 << " with Agent "
+                   << n.task->start->loc % token.col - 1 << ","
+                   << n.task->start->loc / token.col - 1 << " --> "
+                   << n.task->goal->loc % token.col - 1 << ","
+                   << n.task->goal->loc / token.col - 1 << " with Agent "
                    << old_ag->id;
               cout << " at Timestep " << token.timestep << "-->" << arrive_goal
                    << endl;
@@ -369,7 +313,13 @@ bool Agent::TPTR(Token &token, bool verbose) {
             n.task->ag_arrive_goal = arrive_goal;
 
             // pass token
-            if (old_ag->TPTR(token, verbose)) // swap succeed
+            token.changed.push_back(id);
+            token.chain.depth++;
+            token.chain.longest = max(token.chain.longest, token.chain.depth);
+            bool swapped = old_ag->TPTR(token, verbose);
+            token.chain.depth--;
+            token.changed.push_back(old_ag->id);
+            if (swapped) // swap succeed
             {
               return true;
             } else // give up
@@ -377,17 +327,13 @@ bool Agent::TPTR(Token &token, bool verbose) {
               if (verbose)
                 cout << "Swap fails" << endl;
 
-              // // update task
-              // n.task->ag = old_ag;
-              // n.task->ag_arrive_start = old_arrive_start;
-              // n.task->ag_arrive_goal = old_arrive_goal;
-              // // update token path
-              // for (int i = token.timestep; i < token.path[id].size(); i++) {
-              //   path[i] = agent_copy.path[i];
-              //   token.path[id][i] = path[i];
-              // }
-              // this->finish_time = agent_copy.finish_time;
-              // continue;
+              // update task (old_ag has restored its path)
+              n.task->ag = old_ag;
+              n.task->ag_arrive_start = old_arrive_start;
+              n.task->ag_arrive_goal = old_arrive_goal;
+              // update token path
+              restorePath(token, saved_path, saved_finish_time);
+              continue;
             }
           }
 
@@ -407,9 +353,8 @@ bool Agent::TPTR(Token &token, bool verbose) {
   if (!token.ag_tasks[id].empty()) {
     for (int i = token.timestep + 1; i < maxtime; i++) {
       path[i] = path[token.timestep];
-      token.path[id][i] = path[token.timestep];
     }
-    finish_time = token.timestep + 1;
+    token.ag_finish_time[id] = token.timestep + 1;
     return true;
   }
   if (token.my_endpoints[loc]) // if agent is at an endpoint now
@@ -423,22 +368,18 @@ bool Agent::TPTR(Token &token, bool verbose) {
     }
     // check whether agent can hold this location
     for (unsigned int t = token.timestep; t < maxtime && !move; t++) {
-      for (unsigned int i = 0; i < token.agents.size() && !move; i++)
-        if (i != id && token.path[i][t] == loc)
+      const loc_t *locs = token.path.at(t);
+      for (unsigned int i = 0; i < token.path.size() && !move; i++)
+        if (i != id && locs[i] == loc)
           move = true;
     }
     if (move) {
-      if (Move2EP(token)) // move to a nearest empty endpoint
+      if (Move2EP(token, true)) // move to a nearest empty endpoint
       {
-        // update token
-        for (int i = token.timestep; i < token.path[id].size(); i++) {
-          token.path[id][i] = path[i];
-        }
         return true;
       } else {
         // cout << "Agent " << id << " returns token" << endl;
-        token.reset(token_copy);
-        this->reset(agent_copy);
+        restorePath(token, saved_path, saved_finish_time);
         return false;
       }
     } else // wait for one timestep
@@ -447,30 +388,54 @@ bool Agent::TPTR(Token &token, bool verbose) {
       // endl; update path
       for (int i = token.timestep + 1; i < maxtime; i++) {
         path[i] = path[token.timestep];
-        token.path[id][i] = path[token.timestep];
       }
-      finish_time = token.timestep + 1;
+      token.ag_finish_time[id] = token.timestep + 1;
       return true;
     }
 
   } else // agent current location is not an endpoint
   {
-    if (Move2EP(token)) // try to move to a nearest empty endpoint
+    if (Move2EP(token, true)) // try to move to a nearest empty endpoint
     {
-      for (int i = token.timestep; i < token.path[id].size(); i++) {
-        token.path[id][i] = path[i];
-      }
       return true;
     } else // the agent have no place to go, so give up swapping, return false
     {
       // cout << "Agent " << id << " return token" << endl;
-      token.reset(token_copy);
-      this->reset(agent_copy);
+      restorePath(token, saved_path, saved_finish_time);
       return false;
     }
   }
 }
 
+int Agent::Replan(Token &token, Task *task) {
+  int loc = path[token.timestep];
+  int arrive_start = task->ag_arrive_start;
+  int begin_time = token.timestep;
+  if (arrive_start > token.timestep) // not at the start yet
+  {
+    arrive_start = FindPath(loc, token.timestep, *task->start, token, id);
+    if (arrive_start < 0)
+      return -1;
+    loc = task->start->loc;
+    begin_time = arrive_start + task->start_time;
+  }
+  int arrive_goal = FindPath(loc, begin_time, *task->goal, token, id);
+  if (arrive_goal < 0)
+    return -1;
+  token.ag_finish_time[id] = arrive_goal + task->goal_time;
+  task->ag_arrive_start = arrive_start;
+  task->ag_arrive_goal = arrive_goal;
+  return arrive_goal;
+}
+
+void Agent::restorePath(Token &token, const vector<loc_t> &saved_path,
+                        unsigned int saved_finish_time) {
+  for (int i = token.timestep; i < path.size(); i++)
+    path[i] = saved_path[i - token.timestep];
+  token.ag_finish_time[id] = saved_finish_time;
+  token.changed.push_back(id);
+}
+
 void Agent::updatePath(const Node &goal) // update path for agent
 {
   // hold the goal
@@ -500,22 +465,48 @@ inline bool Agent::isConstrained(int curr_id, int next_id, int next_timestep,
 
   // check path constraints (the move from curr_id to next_id at next_timestep-1
   // is disallowed)
+  const loc_t *prev = token.path.at(next_timestep - 1);
+  const loc_t *next = token.path.at(next_timestep);
   for (int ag = 0; ag < token.path.size(); ag++) {
     if (ag == id || ag == ag_hide)
       continue; // ignore its path and the original agent's path
-    else if (token.path[ag][next_timestep] == next_id)
+    else if (next[ag] == next_id)
       return true; // vertex collision
-    else if (token.path[ag][next_timestep - 1] == next_id &&
-             token.path[ag][next_timestep] == curr_id)
+    else if (prev[ag] == next_id && next[ag] == curr_id)
       return true; // edge collision
   }
 
   return false;
 }
 
+int Agent::FindPath(int start_loc, int begin_time, const Endpoint &goal,
+                    Token &token, int ag_hide) {
+  if (path_cache != NULL) {
+    int arrive = path_cache->TryPath(start_loc, begin_time, goal, token, id,
+                                     ag_hide, path);
+    if (arrive < 0 && path_cache->window > 0) {
+      unsigned long expanded = path_cache->expanded;
+      arrive = path_cache->RepairPath(start_loc, begin_time, goal, token, id,
+                                      ag_hide, path);
+      token.chain.expansions += path_cache->expanded - expanded;
+    }
+    if (arrive >= 0)
+      return arrive;
+  }
+  if (sipp == NULL)
+    return AStar(start_loc, begin_time, goal, token, ag_hide);
+  unsigned long expanded = sipp->expanded;
+  int arrive =
+      sipp->FindPath(token, id, ag_hide, start_loc, begin_time, goal, path);
+  token.chain.expansions += sipp->expanded - expanded;
+  return arrive;
+}
+
 // return final timestep if find a path, otherwise renturn -1
 int Agent::AStar(int start_loc, int begin_time, const Endpoint &goal,
-                 const Token &token, int ag_hide) {
+                 Token &token, int ag_hide) {
+  const unsigned int maxtime = path.size();
+  const int map_size = token.my_map.size();
   int goal_location = goal.loc;
   heap_open_t open_list;
   map<unsigned int, Node *> allNodes_table; // key = g_val*map_size+loc
@@ -533,14 +524,16 @@ int Agent::AStar(int start_loc, int begin_time, const Endpoint &goal,
     Node *curr = open_list.top();
     open_list.pop();
     curr->in_openlist = false; // move to closed list
+    token.chain.expansions++;
 
     // check if the popped node is a goal
     if (curr->loc == goal_location) {
       bool hold = true;
       // test whether the goal can be held
       for (unsigned int i = curr->timestep + 1; i < maxtime; i++) {
-        for (unsigned int j = 0; j < token.agents.size(); j++) {
-          if (j != id && j != ag_hide && curr->loc == token.path[j][i]) {
+        const loc_t *locs = token.path.at(i);
+        for (unsigned int j = 0; j < token.path.size(); j++) {
+          if (j != id && j != ag_hide && curr->loc == locs[j]) {
             hold = false;
             break;
           }
@@ -562,7 +555,7 @@ int Agent::AStar(int start_loc, int begin_time, const Endpoint &goal,
 
     int next_id;
     // iterator over all possible actions
-    int action[5] = {0, 1, -1, col, -col};
+    int action[5] = {0, 1, -1, token.col, -token.col};
     for (int i = 0; i < 5; i++) {
       next_id = curr->loc + action[i];
       int next_timestep = curr->timestep + 1;
@@ -577,13 +570,13 @@ int Agent::AStar(int start_loc, int begin_time, const Endpoint &goal,
 
         // try to retrieve it from the hash table
         map<unsigned int, Node *>::iterator it =
-            allNodes_table.find(next->loc + next->g_val * row * col);
+            allNodes_table.find(next->loc + next->g_val * map_size);
         if (it == allNodes_table.end()) // undiscover
         { // add the newly generated node to open_list and hash table
           next->in_openlist = true;
 
           allNodes_table.insert(pair<unsigned int, Node *>(
-              next->loc + next->g_val * row * col, next));
+              next->loc + next->g_val * map_size, next));
           open_list.push(next);
         }
 
@@ -600,17 +593,44 @@ int Agent::AStar(int start_loc, int begin_time, const Endpoint &goal,
   return -1;
 }
 // move to an empty endpoint
-bool Agent::Move2EP(Token &token) {
+bool Agent::Move2EP(Token &token, bool bounded) {
   // BFS algorithm, choose the first empty endpoint to go to
+  const unsigned int maxtime = path.size();
+  const int map_size = token.my_map.size();
+  int loc = token.ag_loc[id];
+  if (bounded && token.chain.OutOfBudget()) {
+    // no more searches in this pass: stay if no agent comes here, else fail
+    for (unsigned int t = token.timestep + 1; t < maxtime; t++) {
+      const loc_t *locs = token.path.at(t);
+      for (unsigned int ag = 0; ag < token.path.size(); ag++) {
+        if (ag != id && locs[ag] == loc)
+          return false;
+      }
+    }
+    for (unsigned int t = token.timestep + 1; t < maxtime; t++)
+      path[t] = loc;
+    token.ag_finish_time[id] = token.timestep + 1;
+    return true;
+  }
+  if (sipp != NULL) {
+    unsigned long expanded = sipp->expanded;
+    int arrive = sipp->FindEndpoint(token, id, loc, token.timestep, path);
+    token.chain.expansions += sipp->expanded - expanded;
+    if (arrive < 0)
+      return false;
+    token.ag_finish_time[id] = arrive;
+    return true;
+  }
   queue<Node *> Q;
   map<unsigned int, Node *> allNodes_table; // key = g_val * map_size + loc
-  int action[5] = {0, 1, -1, col, -col};
+  int action[5] = {0, 1, -1, token.col, -token.col};
   Node *start = new Node(loc, 0, NULL, token.timestep);
   allNodes_table.insert(make_pair(loc, start)); // g_val = 0 --> key = loc
   Q.push(start);
-  while (!Q.empty()) {
+  while (!Q.empty() && !(bounded && token.chain.OutOfBudget())) {
     Node *v = Q.front();
     Q.pop();
+    token.chain.expansions++;
     if (v->timestep >= maxtime - 1)
       continue;                     // time limit
     if (token.my_endpoints[v->loc]) // if v->loc is an endpoint
@@ -618,8 +638,9 @@ bool Agent::Move2EP(Token &token) {
       bool occupied = false;
       // check whether v->loc can be held (no collision with other agents)
       for (unsigned int t = v->timestep; t < maxtime && !occupied; t++) {
-        for (unsigned int ag = 0; ag < token.agents.size() && !occupied; ag++) {
-          if (ag != id && token.path[ag][t] == v->loc)
+        const loc_t *locs = token.path.at(t);
+        for (unsigned int ag = 0; ag < token.path.size() && !occupied; ag++) {
+          if (ag != id && locs[ag] == v->loc)
             occupied = true;
         }
       }
@@ -632,7 +653,7 @@ bool Agent::Move2EP(Token &token) {
       if (!occupied) // If this endpoint is empty, return path
       {
         updatePath(*v);
-        finish_time = v->timestep;
+        token.ag_finish_time[id] = v->timestep;
         // cout << "Agent " << id << " moves to endpoint " << v->loc << endl;
         releaseClosedListNodes(allNodes_table);
         return true;
@@ -645,17 +666,18 @@ bool Agent::Move2EP(Token &token) {
                          id)) {
         // try to retrieve it from the hash table
         map<unsigned int, Node *>::iterator it = allNodes_table.find(
-            v->loc + action[i] + (v->g_val + 1) * row * col);
+            v->loc + action[i] + (v->g_val + 1) * map_size);
         if (it == allNodes_table.end()) // undiscover
         { // add the newly generated node to hash table
           Node *u =
               new Node(v->loc + action[i], v->g_val + 1, v, v->timestep + 1);
           allNodes_table.insert(
-              pair<unsigned int, Node *>(u->loc + u->g_val * row * col, u));
+              pair<unsigned int, Node *>(u->loc + u->g_val * map_size, u));
           Q.push(u);
         }
       }
     }
   }
+  releaseClosedListNodes(allNodes_table);
   return false;
 }
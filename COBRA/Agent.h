@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <list>
 #include <vector>
 
@@ -7,42 +8,150 @@
 #include <string>
 
 #include "Endpoint.h"
+#include "Location.h"
 #include "Node.h"
 
 using namespace std;
 
 class Task;
 class Token;
+class PathCache;
+class SIPP;
 
+// The plan of one agent (path[time] = loc) inside a PathTable, which holds the
+// only copy of it: writing through the view updates the token directly.
+class PathView {
+public:
+  PathView() : first(NULL), stride(0), length(0) {}
+  PathView(loc_t *first, size_t stride, size_t length)
+      : first(first), stride(stride), length(length) {}
+  loc_t &operator[](size_t t) { return first[t * stride]; }
+  loc_t operator[](size_t t) const { return first[t * stride]; }
+  size_t size() const { return length; }
+
+private:
+  loc_t *first;
+  size_t stride;
+  size_t length;
+};
+
+// Paths of all agents, time-major (the locations of all agents at a timestep
+// are contiguous), since collision checks scan every agent at one timestep.
+class PathTable {
+public:
+  PathTable() : num_agents(0), horizon_(0) {}
+  void resize(size_t num_agents, size_t horizon) {
+    this->num_agents = num_agents;
+    horizon_ = horizon;
+    locs.assign(num_agents * horizon, 0);
+  }
+  // copies the paths of a table of the same size, keeping the views valid
+  void reset(const PathTable &table) {
+    copy(table.locs.begin(), table.locs.end(), locs.begin());
+  }
+  PathView operator[](size_t ag) {
+    return PathView(locs.data() + ag, num_agents, horizon_);
+  }
+  const PathView operator[](size_t ag) const {
+    return PathView(const_cast<loc_t *>(locs.data()) + ag, num_agents,
+                    horizon_);
+  }
+  // locations of all agents at timestep t
+  const loc_t *at(size_t t) const { return locs.data() + t * num_agents; }
+  size_t size() const { return num_agents; } // number of agents
+
+private:
+  size_t num_agents;
+  size_t horizon_;
+  vector<loc_t> locs; // locs[time * num_agents + agent]
+};
+
+// Limits and statistics of the task-robbing chains of TPTR: an agent robs a
+// task, the robbed agent looks for another task and may rob one in turn...
+// One chain per token pass.
+struct RobbingChain {
+  RobbingChain()
+      : max_depth(0), max_expansions(0), depth(0), longest(0), expansions(0),
+        exhausted(false) {}
+  void Start() { // a new token pass
+    depth = longest = 0;
+    expansions = 0;
+    exhausted = false;
+  }
+  bool CanRob() const { return max_depth == 0 || depth < max_depth; }
+  bool OutOfBudget() {
+    if (max_expansions > 0 && expansions >= max_expansions)
+      exhausted = true;
+    return exhausted;
+  }
+
+  unsigned int max_depth;       // robberies in a chain, 0: unbounded
+  unsigned long max_expansions; // search expansions per pass, 0: unbounded
+  unsigned int depth;           // robberies above the planning agent
+  unsigned int longest;         // robberies in the chain of this pass
+  unsigned long expansions;     // search expansions in this pass
+  bool exhausted;               // the budget ran out in this pass
+};
+
+// Agents whose paths may have changed, in order (-1: all, after a reset).
+// Readers keep the index of the first entry they have not read: indexes count
+// every entry ever logged, and all the entries are dropped once there are
+// capacity of them, so a reader left behind re-reads every path instead.
+class ChangeLog {
+public:
+  ChangeLog() : first(0) {}
+  void push_back(int ag) {
+    if (entries.size() >= capacity) {
+      first += entries.size();
+      entries.clear();
+    }
+    entries.push_back(ag);
+  }
+  int operator[](size_t i) const { return entries[i - first]; }
+  size_t oldest() const { return first; }                  // first entry kept
+  size_t size() const { return first + entries.size(); } // past the newest
+
+  static const size_t capacity = 1 << 16;
+
+private:
+  size_t first;
+  vector<int> entries;
+};
+
+// Plans for one agent; its state lives in the per-agent arrays of Token.
 class Agent {
 public:
-  Agent(){};
-  Agent(int loc, int col, int row, int id, int maxtime);
-  Agent(const Agent &ag);
-  ~Agent();
-  void Set(int loc, int col, int row, int id, unsigned int maxtime);
-  void reset(const Agent &ag);
+  Agent() : id(-1), sipp(NULL), path_cache(NULL) {}
+  // fills the agent's path with loc and resets its state in token
+  void Set(int id, int loc, Token &token);
   bool TOTP(Token &token, bool verbose); // time ordered token passing
   bool TPTR(Token &token, bool verbose); // token passing and task robbing
+  // plans the rest of task again from token.timestep, returns the arrival at
+  // the goal (-1 if none, the path is then partly overwritten)
+  int Replan(Token &token, Task *task);
 
 public:
-  vector<unsigned int> path;
-  int loc;
   int id;
-  unsigned int maxtime;
-  unsigned int finish_time; // time that the robot finishs the current task
-  Task *task;
-  int row;
-  int col;
+  PathView path;
+  SIPP *sipp; // plans with safe intervals instead of AStar (or NULL)
+  PathCache *path_cache; // cached paths tried before searching (or NULL)
 
 private:
-  int AStar(int start, int begin_time, const Endpoint &goal, const Token &token,
+  // cached path, else AStar or SIPP, return timestep or -1
+  int FindPath(int start, int begin_time, const Endpoint &goal, Token &token,
+               int ag_hide);
+  int AStar(int start, int begin_time, const Endpoint &goal, Token &token,
             int ag_hide); // return timestep or -1
   void updatePath(const Node &goal);
   inline void releaseClosedListNodes(map<unsigned int, Node *> &allNodes_table);
   inline bool isConstrained(int curr_id, int next_id, int next_timestep,
                             const Token &token, int ag_hide);
-  bool Move2EP(Token &token); // move to empty endpoint
+  // move to empty endpoint; bounded by the expansion budget of the robbing
+  // chain (TPTR), it only stays where it is once the budget runs out
+  bool Move2EP(Token &token, bool bounded);
+  // back to the plan saved when TPTR started (from token.timestep on)
+  void restorePath(Token &token, const vector<loc_t> &saved_path,
+                   unsigned int saved_finish_time);
 };
 
 typedef enum { WAIT, TAKEN } TaskState;
@@ -51,7 +160,7 @@ class Task {
 public:
   Task(unsigned int id, Endpoint *start, Endpoint *goal, int start_time,
        int goal_time, int aid)
-      : id(id), start(start), goal(goal), start_time(start_time),
+      : id(id), start(start), goal(goal), ag(NULL), start_time(start_time),
         goal_time(goal_time), state(WAIT), ag_arrive_start(start_time),
         ag_arrive_goal(start_time), aid(aid) {}
   ~Task() {}
@@ -71,7 +180,7 @@ public:
 
 class Token {
 public:
-  Token() { timestep = 0; }
+  Token() { timestep = 0; col = 0; }
   Token(const Token &token);
   ~Token() {}
   void reset(const Token &token);
@@ -80,8 +189,12 @@ public:
   vector<bool> my_endpoints;
   list<Task *> tasks;
   vector<list<Task *>> ag_tasks;
-  vector<Agent *> agents;
+  vector<loc_t> ag_loc;                // current location of every agent
+  vector<unsigned int> ag_finish_time; // time that the agent finishs its task
 
-  vector<vector<unsigned int>> path; // path[agent][time] = loc
+  PathTable path; // path[agent][time] = loc
   unsigned int timestep;
+  ChangeLog changed; // agents whose paths may have changed
+  RobbingChain chain; // not restored by reset
+  int col; // width of my_map
 };
@@ -1,5 +1,10 @@
 #include "Endpoint.h"
 #include <queue>
+#include <algorithm>
+#include <stdint.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 
 //Endpoint::Endpoint(int loc, const vector<bool> &map, int col, int pt):loc(loc),processing_time(pt)
@@ -42,4 +47,89 @@ vector<int> Endpoint::BFS(const vector<bool> &map, int col)
 		}		
 	}
 	return h;
-}
\ No newline at end of file
+}
+
+//index of the lowest set bit (bits != 0)
+static inline int LowestBit(uint64_t bits)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, bits);
+	return index;
+#else
+	return __builtin_ctzll(bits);
+#endif
+}
+
+//Bit-parallel BFS: bit b of a cell's word stands for the b-th endpoint of the batch, so one sweep over the
+//frontier cells advances all 64 searches by one layer. Endpoints are batched by 8x8 tiles of the map, which keeps
+//the frontiers of a batch overlapping (a cell then joins the frontier for a few layers instead of once per endpoint).
+void Endpoint::SetHVals(vector<Endpoint> &endpoints, const vector<bool> &map, int col)
+{
+	const int BATCH = 64;
+	int neighbor[4] = { 1,-1,col,-col };
+	vector<pair<pair<int, int>, size_t> > tiles(endpoints.size());
+	for (size_t e = 0; e < endpoints.size(); e++)
+		tiles[e] = make_pair(make_pair(endpoints[e].loc / col / 8, endpoints[e].loc % col / 8), e);
+	sort(tiles.begin(), tiles.end());
+
+	int map_size = map.size();
+	vector<uint64_t> blocked(map_size), visited(map_size), frontier(map_size, 0), next(map_size, 0);
+	for (int u = 0; u < map_size; u++)
+		blocked[u] = map[u] ? 0 : ~(uint64_t)0; //blocked cells count as visited by every search
+	int* h[BATCH]; //h_val of the endpoints of the batch
+	vector<int> active, next_active;
+	for (size_t first = 0; first < endpoints.size(); first += BATCH)
+	{
+		int num = endpoints.size() - first < BATCH ? endpoints.size() - first : BATCH;
+		visited = blocked;
+		active.clear();
+		for (int b = 0; b < num; b++)
+		{
+			Endpoint &ep = endpoints[tiles[first + b].second];
+			ep.h_val.assign(map_size, -1);
+			h[b] = &ep.h_val[0];
+			h[b][ep.loc] = 0;
+			if (frontier[ep.loc] == 0)
+				active.push_back(ep.loc);
+			frontier[ep.loc] |= (uint64_t)1 << b;
+			visited[ep.loc] |= (uint64_t)1 << b;
+		}
+		for (int d = 1; !active.empty(); d++)
+		{
+			next_active.clear();
+			for (size_t i = 0; i < active.size(); i++)
+			{
+				int v = active[i];
+				uint64_t expanding = frontier[v];
+				for (int k = 0; k < 4; k++)
+				{
+					int u = v + neighbor[k];
+					uint64_t reached = expanding & ~visited[u];
+					if (reached)
+					{
+						if (next[u] == 0)
+							next_active.push_back(u);
+						next[u] |= reached;
+					}
+				}
+			}
+			for (size_t i = 0; i < active.size(); i++)
+				frontier[active[i]] = 0;
+			for (size_t i = 0; i < next_active.size(); i++)
+			{
+				int u = next_active[i];
+				uint64_t reached = next[u];
+				visited[u] |= reached;
+				frontier[u] = reached;
+				next[u] = 0;
+				while (reached)
+				{
+					h[LowestBit(reached)][u] = d;
+					reached &= reached - 1;
+				}
+			}
+			active.swap(next_active);
+		}
+	}
+}
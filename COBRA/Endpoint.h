@@ -12,6 +12,8 @@ public:
 	Endpoint(int loc) :loc(loc) {};
 	~Endpoint();
 	void SetHVal(const vector<bool> &map, int col) { h_val = BFS(map, col); }
+	//same as SetHVal for every endpoint, 64 endpoints per BFS
+	static void SetHVals(vector<Endpoint> &endpoints, const vector<bool> &map, int col);
 
 
 	int id;//endpoint id
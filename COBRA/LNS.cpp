@@ -0,0 +1,132 @@
+#include "LNS.h"
+
+#include <chrono>
+#include <iostream>
+
+int LNS::LowerBound(const Token &token, int ag) const {
+  const Task *t = task[ag];
+  int loc = token.path[ag][token.timestep];
+  if (t->ag_arrive_start > token.timestep)
+    return token.timestep + t->start->h_val[loc] + t->start_time +
+           t->goal->h_val[t->start->loc];
+  return token.timestep + t->goal->h_val[loc];
+}
+
+void LNS::Neighborhood(const Token &token, int seed) {
+  const PathView seed_path = token.path[seed];
+  round++;
+  for (unsigned int t = token.timestep; t <= task[seed]->ag_arrive_goal; t++)
+    mark[seed_path[t]] = round;
+  crossing.clear();
+  for (unsigned int ag = 0; ag < task.size(); ag++) {
+    if (task[ag] == NULL || ag == seed)
+      continue;
+    const PathView path = token.path[ag];
+    for (unsigned int t = token.timestep; t <= task[ag]->ag_arrive_goal; t++) {
+      if (mark[path[t]] == round) {
+        crossing.push_back(ag);
+        break;
+      }
+    }
+  }
+  shuffle(crossing.begin(), crossing.end(), rng);
+  neighbors.assign(1, seed);
+  for (unsigned int i = 0;
+       i < crossing.size() && neighbors.size() < neighborhood_size; i++)
+    neighbors.push_back(crossing[i]);
+}
+
+int LNS::Run(Token &token, vector<Agent> &agents, const vector<Task *> &ag_task,
+             double budget_ms, bool verbose) {
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  const unsigned int maxtime = token.path[0].size();
+  // agents with a task whose path holds its goal, and that do not wait at the
+  // start right now
+  task = ag_task;
+  for (unsigned int ag = 0; ag < task.size(); ag++) {
+    const Task *t = task[ag];
+    if (t != NULL &&
+        (t->ag_arrive_goal <= token.timestep ||
+         token.path[ag][maxtime - 1] != t->goal->loc ||
+         (t->ag_arrive_start <= token.timestep &&
+          token.timestep < t->ag_arrive_start + t->start_time)))
+      task[ag] = NULL;
+  }
+  mark.assign(token.my_map.size(), 0);
+  round = 0;
+
+  int improvement = 0, iterations = 0, accepted = 0;
+  vector<int> delayed;
+  vector<vector<loc_t>> saved_path;
+  vector<unsigned int> saved_finish, saved_start, saved_goal;
+  while (std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+             .count() < budget_ms) {
+    delayed.clear();
+    for (unsigned int ag = 0; ag < task.size(); ag++) {
+      if (task[ag] != NULL &&
+          (int)task[ag]->ag_arrive_goal > LowerBound(token, ag))
+        delayed.push_back(ag);
+    }
+    if (delayed.empty())
+      break;
+    iterations++;
+    Neighborhood(token, delayed[rng() % delayed.size()]);
+
+    // remove the paths of the neighborhood
+    int num = neighbors.size(), old_cost = 0;
+    saved_path.resize(num);
+    saved_finish.resize(num);
+    saved_start.resize(num);
+    saved_goal.resize(num);
+    for (int i = 0; i < num; i++) {
+      int ag = neighbors[i];
+      PathView &path = agents[ag].path;
+      saved_path[i].assign(maxtime - token.timestep, 0);
+      for (unsigned int t = token.timestep; t < maxtime; t++) {
+        saved_path[i][t - token.timestep] = path[t];
+        if (t > token.timestep)
+          path[t] = 0; // a cell of the blocked border
+      }
+      saved_finish[i] = token.ag_finish_time[ag];
+      saved_start[i] = task[ag]->ag_arrive_start;
+      saved_goal[i] = task[ag]->ag_arrive_goal;
+      old_cost += task[ag]->ag_arrive_goal;
+      token.changed.push_back(ag);
+    }
+
+    // replan them in a random order
+    order = neighbors;
+    shuffle(order.begin(), order.end(), rng);
+    int new_cost = 0;
+    for (int i = 0; i < num && new_cost >= 0; i++) {
+      int ag = order[i];
+      int arrive = agents[ag].Replan(token, task[ag]);
+      token.changed.push_back(ag);
+      new_cost = arrive < 0 ? -1 : new_cost + arrive;
+    }
+
+    if (0 <= new_cost && new_cost < old_cost) {
+      improvement += old_cost - new_cost;
+      accepted++;
+      continue;
+    }
+    // back to the old paths
+    for (int i = 0; i < num; i++) {
+      int ag = neighbors[i];
+      PathView &path = agents[ag].path;
+      for (unsigned int t = token.timestep; t < maxtime; t++)
+        path[t] = saved_path[i][t - token.timestep];
+      token.ag_finish_time[ag] = saved_finish[i];
+      task[ag]->ag_arrive_start = saved_start[i];
+      task[ag]->ag_arrive_goal = saved_goal[i];
+      token.changed.push_back(ag);
+    }
+  }
+  if (verbose)
+    cout << "LNS: " << accepted << " of " << iterations
+         << " neighborhoods improved, arrivals reduced by " << improvement
+         << endl;
+  return improvement;
+}
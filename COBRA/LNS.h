@@ -0,0 +1,40 @@
+#pragma once
+#include <random>
+#include <vector>
+
+#include "Agent.h"
+
+using namespace std;
+
+// Large neighborhood search (Li et al., 2021) over the paths in a Token. It
+// repeatedly takes a delayed agent and some of the agents whose paths cross
+// its path, and removes their paths by parking them on a blocked cell, which
+// no planner enters. It then replans them one by one in a random order and
+// keeps the new paths only if the sum of their arrival timesteps at the goals
+// is smaller. Only the paths from token.timestep on change.
+class LNS {
+public:
+  LNS() : neighborhood_size(8), rng(0) {}
+
+  // improves the paths of the agents doing ag_task[ag] (NULL for none) until
+  // budget_ms has passed or no agent is delayed, returns the reduction of the
+  // sum of the arrival timesteps
+  int Run(Token &token, vector<Agent> &agents, const vector<Task *> &ag_task,
+          double budget_ms, bool verbose);
+
+  unsigned int neighborhood_size;
+
+private:
+  // arrival of ag at the goal if no other agent were in the way
+  int LowerBound(const Token &token, int ag) const;
+  // the seed and up to neighborhood_size - 1 agents crossing its path
+  void Neighborhood(const Token &token, int seed);
+
+  vector<Task *> task;   // per agent, NULL if its path cannot be replanned
+  vector<int> neighbors; // current neighborhood
+  vector<int> order;     // neighbors in the order they are replanned
+  vector<int> crossing;  // agents crossing the path of the seed
+  vector<unsigned int> mark; // per cell, cells of the seed's path
+  unsigned int round;
+  mt19937 rng;
+};
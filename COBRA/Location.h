@@ -0,0 +1,10 @@
+#pragma once
+#include <stdint.h>
+
+// Location of a cell (row * col + column, border included). Building with
+// COBRA_LOC16 halves the path store for maps of at most 65535 cells.
+#ifdef COBRA_LOC16
+typedef uint16_t loc_t;
+#else
+typedef uint32_t loc_t;
+#endif
@@ -0,0 +1,263 @@
+#include "PIBT.h"
+
+#include <climits>
+#include <iostream>
+
+void PIBT::Set(const Token &token, vector<Agent> &agents,
+               const vector<Endpoint *> &home) {
+  int num_agents = agents.size();
+  this->agents = &agents;
+  this->home = home;
+  my_map = &token.my_map;
+  my_endpoints = &token.my_endpoints;
+  col = token.col;
+  task.assign(num_agents, NULL);
+  to_goal.assign(num_agents, false);
+  busy.assign(num_agents, 0);
+  elapsed.assign(num_agents, 0);
+  locs.assign(num_agents, -1);
+  next.assign(num_agents, -1);
+  order.resize(num_agents);
+  for (int ag = 0; ag < num_agents; ag++)
+    order[ag] = ag;
+  num_busy = 0;
+  occupied_now.assign(token.my_map.size(), -1);
+  occupied_next.assign(token.my_map.size(), -1);
+  cell_task.assign(token.my_map.size(), -1);
+  visited.assign(token.my_map.size(), 0);
+  visit = 0;
+}
+
+void PIBT::Update(int ag, int timestep) {
+  Task *t = task[ag];
+  if (t == NULL)
+    return;
+  if (!to_goal[ag] && locs[ag] == t->start->loc) {
+    t->ag_arrive_start = timestep;
+    to_goal[ag] = true;
+    busy[ag] = timestep + t->start_time;
+  }
+  if (to_goal[ag] && locs[ag] == t->goal->loc && timestep >= busy[ag]) {
+    t->ag_arrive_goal = timestep;
+    busy[ag] = timestep + t->goal_time;
+    task[ag] = NULL;
+    elapsed[ag] = 0;
+    num_busy--;
+  }
+}
+
+void PIBT::Assign(Token &token, bool verbose) {
+  task_h.clear();
+  task_it.clear();
+  task_loc.clear();
+  for (list<Task *>::iterator it = token.tasks.begin(); it != token.tasks.end();
+       it++) {
+    if ((*it)->state == WAIT) {
+      task_h.push_back((*it)->start->h_val.data());
+      task_it.push_back(it);
+      task_loc.push_back((*it)->start->loc);
+    }
+  }
+  int num_left = task_h.size();
+  // tasks by start cell, oldest first, for the BFS
+  if (num_left > 64) {
+    task_next.resize(task_h.size());
+    for (int j = task_h.size() - 1; j >= 0; j--) {
+      task_next[j] = cell_task[task_loc[j]];
+      cell_task[task_loc[j]] = j;
+    }
+  }
+
+  for (unsigned int i = 0; i < order.size(); i++) {
+    int ag = order[i];
+    if (task[ag] != NULL || timestep < busy[ag])
+      continue;
+    // the nearest of its own tasks
+    list<Task *> &tasks = token.ag_tasks[ag];
+    list<Task *>::iterator best = tasks.end();
+    for (list<Task *>::iterator it = tasks.begin(); it != tasks.end(); it++) {
+      int h = (*it)->start->h_val[locs[ag]];
+      if ((*it)->state == WAIT && h >= 0 &&
+          (best == tasks.end() || h < (*best)->start->h_val[locs[ag]]))
+        best = it;
+    }
+    if (best != tasks.end()) {
+      Take(*best, ag, verbose);
+      tasks.erase(best);
+      continue;
+    }
+    if (!tasks.empty() || num_left == 0)
+      continue;
+    // else the nearest of Token::tasks, by a BFS if there are many
+    int nearest = num_left > 64 ? FindTask(locs[ag]) : ScanTasks(locs[ag]);
+    if (nearest >= 0) {
+      Take(*task_it[nearest], ag, verbose);
+      token.tasks.erase(task_it[nearest]);
+      task_h[nearest] = NULL;
+      num_left--;
+    }
+  }
+  for (unsigned int j = 0; j < task_next.size(); j++)
+    cell_task[task_loc[j]] = -1;
+  task_next.clear();
+}
+
+int PIBT::ScanTasks(int loc) const {
+  int nearest = -1, h_nearest = 0;
+  for (unsigned int j = 0; j < task_h.size() && (nearest < 0 || h_nearest > 0);
+       j++) {
+    if (task_h[j] == NULL)
+      continue;
+    int h = task_h[j][loc];
+    if (h >= 0 && (nearest < 0 || h < h_nearest)) {
+      nearest = j;
+      h_nearest = h;
+    }
+  }
+  return nearest;
+}
+
+int PIBT::FindTask(int loc) {
+  visit++;
+  visited[loc] = visit;
+  bfs.clear();
+  bfs.push_back(loc);
+  int action[4] = {1, -1, col, -col};
+  // the oldest task among the nearest ones, as ScanTasks
+  int nearest = -1;
+  unsigned int level_end = 1;
+  for (unsigned int i = 0; i < bfs.size(); i++) {
+    if (i == level_end) {
+      if (nearest >= 0)
+        return nearest;
+      level_end = bfs.size();
+    }
+    for (int j = cell_task[bfs[i]]; j >= 0; j = task_next[j]) {
+      if (task_h[j] != NULL) {
+        if (nearest < 0 || j < nearest)
+          nearest = j;
+        break;
+      }
+    }
+    if (nearest >= 0)
+      continue;
+    for (int k = 0; k < 4; k++) {
+      int next_loc = bfs[i] + action[k];
+      if ((*my_map)[next_loc] && visited[next_loc] != visit) {
+        visited[next_loc] = visit;
+        bfs.push_back(next_loc);
+      }
+    }
+  }
+  return nearest;
+}
+
+void PIBT::Take(Task *t, int ag, bool verbose) {
+  // arrivals are estimated from the distances until they happen
+  t->state = TAKEN;
+  t->ag = &(*agents)[ag];
+  t->ag_arrive_start = timestep + t->start->h_val[locs[ag]];
+  t->ag_arrive_goal =
+      t->ag_arrive_start + t->start_time + t->goal->h_val[t->start->loc];
+  task[ag] = t;
+  to_goal[ag] = false;
+  num_busy++;
+  if (verbose)
+    cout << "Agent " << ag << " take task " << t->id << " "
+         << t->start->loc % col - 1 << "," << t->start->loc / col - 1
+         << " --> " << t->goal->loc % col - 1 << "," << t->goal->loc / col - 1
+         << " at Timestep " << timestep << endl;
+  Update(ag, timestep); // the agent may be at the start already
+}
+
+const Endpoint *PIBT::Target(int ag) const {
+  if (task[ag] != NULL)
+    return to_goal[ag] ? task[ag]->goal : task[ag]->start;
+  if ((*my_endpoints)[locs[ag]])
+    return NULL;
+  return home[ag];
+}
+
+void PIBT::Step(Token &token, bool verbose) {
+  timestep = token.timestep;
+  int num_agents = locs.size();
+  for (int ag = 0; ag < num_agents; ag++) {
+    locs[ag] = (*agents)[ag].path[timestep];
+    occupied_now[locs[ag]] = ag;
+    Update(ag, timestep);
+  }
+
+  // agents that waited the longest for their task first, then by id
+  for (int ag = 0; ag < num_agents; ag++) {
+    if (task[ag] != NULL)
+      elapsed[ag]++;
+  }
+  sort(order.begin(), order.end(), [this](int a, int b) {
+    return elapsed[a] != elapsed[b] ? elapsed[a] > elapsed[b] : a < b;
+  });
+
+  Assign(token, verbose);
+
+  for (int i = 0; i < num_agents; i++) {
+    int ag = order[i];
+    if (next[ag] < 0)
+      Plan(ag);
+  }
+
+  for (int ag = 0; ag < num_agents; ag++) {
+    (*agents)[ag].path[timestep + 1] = next[ag];
+    token.ag_finish_time[ag] = timestep + 1;
+  }
+  for (int ag = 0; ag < num_agents; ag++) {
+    occupied_now[locs[ag]] = -1;
+    occupied_next[next[ag]] = -1;
+    next[ag] = -1;
+  }
+}
+
+bool PIBT::Plan(int ag) {
+  int loc = locs[ag];
+  const Endpoint *target = Target(ag);
+  // staying first, then the neighbors
+  int candidates[5] = {loc};
+  int num_candidates = 1;
+  if (timestep >= busy[ag]) {
+    int action[4] = {1, -1, col, -col};
+    for (int i = 0; i < 4; i++) {
+      if ((*my_map)[loc + action[i]])
+        candidates[num_candidates++] = loc + action[i];
+    }
+  }
+  // closer to the target first, then free cells first (insertion sort)
+  int key[5];
+  for (int i = 0; i < num_candidates; i++) {
+    int c = candidates[i];
+    int h = target != NULL ? target->h_val[c] : (c == loc ? 0 : 1);
+    if (h < 0)
+      h = INT_MAX / 4; // the target cannot be reached from c
+    key[i] = 2 * h + (occupied_now[c] >= 0 && c != loc);
+    for (int j = i; j > 0 && key[j] < key[j - 1]; j--) {
+      swap(key[j], key[j - 1]);
+      swap(candidates[j], candidates[j - 1]);
+    }
+  }
+
+  for (int i = 0; i < num_candidates; i++) {
+    int c = candidates[i];
+    if (occupied_next[c] >= 0)
+      continue; // another agent moves there
+    int other = occupied_now[c];
+    if (other >= 0 && other != ag && next[other] == loc)
+      continue; // swap with the agent there
+    occupied_next[c] = ag;
+    next[ag] = c;
+    // the agent there moves away first, with the priority of ag
+    if (other >= 0 && other != ag && next[other] < 0 && !Plan(other))
+      continue;
+    return true;
+  }
+  // no cell is free, stay (whoever pushed ag tries another cell)
+  next[ag] = loc;
+  occupied_next[loc] = ag;
+  return false;
+}
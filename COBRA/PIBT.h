@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+
+#include "Agent.h"
+
+using namespace std;
+
+// Priority inheritance with backtracking (Okumura et al., 2019): instead of
+// full paths to the goal, every timestep each agent only picks its next cell,
+// in priority order. An agent moving into an occupied cell lends its priority
+// to the occupant, which must move away first, or both try another cell. It
+// costs O(agents) per timestep whatever the horizon, at the price of the
+// optimality of the paths.
+//
+// Free agents take the nearest task of Token::tasks (their own tasks of
+// Token::ag_tasks first), and are guided to its start, then its goal, by the
+// h_val of the endpoints. Agents without a task go back to an endpoint.
+class PIBT {
+public:
+  // home[ag]: the endpoint agent ag goes back to when it has no task
+  void Set(const Token &token, vector<Agent> &agents,
+           const vector<Endpoint *> &home);
+
+  // moves every agent from token.timestep to token.timestep + 1 (writes
+  // token.path there), taking tasks and recording their arrival timesteps
+  void Step(Token &token, bool verbose);
+
+  // some agent is still doing a task
+  bool Busy() const { return num_busy > 0; }
+
+private:
+  // records the arrival of agent ag at the start or goal of its task
+  void Update(int ag, int timestep);
+  // gives tasks to the free agents
+  void Assign(Token &token, bool verbose);
+  void Take(Task *t, int ag, bool verbose);
+  // the nearest task of task_h from loc (-1 if none), by reading the h_val of
+  // every task or by a BFS from loc when there are many tasks
+  int ScanTasks(int loc) const;
+  int FindTask(int loc);
+  // the cell the agent is heading to, NULL to stay where it is
+  const Endpoint *Target(int ag) const;
+  // picks the next cell of ag, false if it has to stay (and is in the way of
+  // the agent pushing it)
+  bool Plan(int ag);
+
+  vector<Agent> *agents;
+  vector<Endpoint *> home;
+  const vector<bool> *my_map;
+  const vector<bool> *my_endpoints;
+  int col;
+
+  // per agent
+  vector<Task *> task;          // current task (or NULL)
+  vector<bool> to_goal;         // reached the start of the task
+  vector<unsigned int> busy;    // stays until then (time at start or goal)
+  vector<unsigned int> elapsed; // timesteps since the task was taken
+  vector<int> locs;             // current cell
+  vector<int> next;             // next cell (-1 until planned)
+  vector<int> order;            // agents by priority
+  // h_val of the start of every task of Token::tasks, or NULL once taken
+  vector<const int *> task_h;
+  vector<list<Task *>::iterator> task_it;
+  vector<int> task_loc;
+  vector<int> task_next; // next task with the same start (BFS only)
+  vector<int> cell_task; // first task starting at every cell (BFS only)
+  vector<unsigned int> visited; // BFS
+  unsigned int visit;
+  vector<int> bfs;
+  int num_busy;
+  unsigned int timestep;
+
+  // per cell, the agent there now and the one there next (-1 for none)
+  vector<int> occupied_now;
+  vector<int> occupied_next;
+};
@@ -0,0 +1,181 @@
+#include "PathCache.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+const vector<loc_t> &PathCache::Get(int start_loc, const Endpoint &goal) {
+  uint64_t key = (uint64_t)goal.id * map_size + start_loc;
+  unordered_map<uint64_t, vector<loc_t>>::iterator it = paths.find(key);
+  if (it != paths.end())
+    return it->second;
+
+  vector<loc_t> &cells = paths[key];
+  if (goal.h_val[start_loc] < 0) // unreachable
+    return cells;
+  int action[4] = {1, -1, col, -col};
+  int loc = start_loc;
+  cells.push_back(loc);
+  while (loc != goal.loc) {
+    for (int i = 0; i < 4; i++) {
+      int next = loc + action[i];
+      if (goal.h_val[next] == goal.h_val[loc] - 1) { // blocked cells are -1
+        loc = next;
+        break;
+      }
+    }
+    cells.push_back(loc);
+  }
+  return cells;
+}
+
+int PathCache::TryPath(int start_loc, int begin_time, const Endpoint &goal,
+                       const Token &token, int ag_self, int ag_hide,
+                       PathView &path) {
+  const vector<loc_t> &cells = Get(start_loc, goal);
+  int maxtime = path.size();
+  int arrive = begin_time + (int)cells.size() - 1;
+  if (cells.empty() || arrive > maxtime - 1)
+    return -1;
+
+  if (!CanHoldGoal(token, ag_self, ag_hide, goal, arrive))
+    return -1;
+  int num_agents = token.path.size();
+  // vertex and edge collisions along the way
+  for (int i = 1; i < (int)cells.size(); i++) {
+    const loc_t *prev = token.path.at(begin_time + i - 1);
+    const loc_t *next = token.path.at(begin_time + i);
+    for (int ag = 0; ag < num_agents; ag++) {
+      if (ag == ag_self || ag == ag_hide)
+        continue;
+      if (next[ag] == cells[i] ||
+          (prev[ag] == cells[i] && next[ag] == cells[i - 1]))
+        return -1;
+    }
+  }
+
+  for (int i = 0; i < (int)cells.size(); i++)
+    path[begin_time + i] = cells[i];
+  for (int t = arrive + 1; t < maxtime; t++)
+    path[t] = goal.loc;
+  return arrive;
+}
+
+bool PathCache::CanHoldGoal(const Token &token, int ag_self, int ag_hide,
+                            const Endpoint &goal, int from) const {
+  // from the end, since agents that stay at the goal hold it till then
+  int num_agents = token.path.size();
+  for (int t = token.path[0].size() - 1; t > from; t--) {
+    const loc_t *locs = token.path.at(t);
+    for (int ag = 0; ag < num_agents; ag++) {
+      if (ag != ag_self && ag != ag_hide && locs[ag] == goal.loc)
+        return false;
+    }
+  }
+  return true;
+}
+
+bool PathCache::IsBlocked(const Token &token, int ag_self, int ag_hide,
+                          int from, int to, int timestep) const {
+  const loc_t *prev = token.path.at(timestep - 1);
+  const loc_t *next = token.path.at(timestep);
+  int num_agents = token.path.size();
+  for (int ag = 0; ag < num_agents; ag++) {
+    if (ag == ag_self || ag == ag_hide)
+      continue;
+    if (next[ag] == to || (prev[ag] == to && next[ag] == from))
+      return true;
+  }
+  return false;
+}
+
+int PathCache::RepairPath(int start_loc, int begin_time, const Endpoint &goal,
+                          const Token &token, int ag_self, int ag_hide,
+                          PathView &path) {
+  const vector<loc_t> &cells = Get(start_loc, goal);
+  int maxtime = path.size();
+  if (cells.empty())
+    return -1;
+  int last = cells.size() - 1;
+
+  // at cells[i] at timestep t
+  int i = 0, t = begin_time, repairs = 0;
+  route.assign(1, cells[0]);
+  while (true) {
+    // follow the route up to the next collision
+    while (i < last && t + 1 < maxtime &&
+           !IsBlocked(token, ag_self, ag_hide, cells[i], cells[i + 1], t + 1)) {
+      i++;
+      t++;
+      route.push_back(cells[i]);
+    }
+    if (i == last)
+      break;
+    if (t + 1 >= maxtime || repairs++ == max_repairs)
+      return -1;
+    // and go around it
+    int j = min(i + window, last);
+    t = SearchWindow(token, ag_self, ag_hide, cells[i], t, cells[j],
+                     min(t + (j - i) + window, maxtime - 1), goal,
+                     begin_time);
+    if (t < 0)
+      return -1;
+    i = j;
+  }
+
+  if (!CanHoldGoal(token, ag_self, ag_hide, goal, t))
+    return -1;
+  for (int u = begin_time; u <= t; u++)
+    path[u] = route[u - begin_time];
+  for (int u = t + 1; u < maxtime; u++)
+    path[u] = goal.loc;
+  return t;
+}
+
+int PathCache::SearchWindow(const Token &token, int ag_self, int ag_hide,
+                            int from, int begin_time, int to, int last_time,
+                            const Endpoint &goal, int route_begin) {
+  // to is on a shortest path to goal, so h_val[loc] - h_val[to] is admissible
+  typedef pair<pair<int, int>, int> OpenEntry; // ((f-val, -timestep), node)
+  priority_queue<OpenEntry, vector<OpenEntry>, greater<OpenEntry>> open;
+  nodes.clear();
+  visited.clear();
+  WindowNode first = {from, begin_time, -1};
+  nodes.push_back(first);
+  visited.insert((uint64_t)begin_time * map_size + from);
+  open.push(make_pair(
+      make_pair(begin_time + goal.h_val[from] - goal.h_val[to], -begin_time),
+      0));
+
+  int action[5] = {0, 1, -1, col, -col};
+  while (!open.empty()) {
+    int n = open.top().second;
+    open.pop();
+    WindowNode curr = nodes[n];
+    expanded++;
+    if (curr.loc == to) {
+      route.resize(curr.timestep - route_begin + 1);
+      for (; n >= 0 && nodes[n].timestep > begin_time; n = nodes[n].parent)
+        route[nodes[n].timestep - route_begin] = nodes[n].loc;
+      return curr.timestep;
+    }
+    if (curr.timestep >= last_time)
+      continue;
+    for (int k = 0; k < 5; k++) {
+      int next_loc = curr.loc + action[k];
+      int next_time = curr.timestep + 1;
+      if (!token.my_map[next_loc] || goal.h_val[next_loc] < 0 ||
+          IsBlocked(token, ag_self, ag_hide, curr.loc, next_loc, next_time))
+        continue;
+      if (!visited.insert((uint64_t)next_time * map_size + next_loc).second)
+        continue;
+      WindowNode next = {next_loc, next_time, n};
+      nodes.push_back(next);
+      open.push(make_pair(make_pair(next_time + goal.h_val[next_loc] -
+                                        goal.h_val[to],
+                                    -next_time),
+                          (int)nodes.size() - 1));
+    }
+  }
+  return -1;
+}
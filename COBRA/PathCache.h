@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Agent.h"
+
+using namespace std;
+
+// Shortest paths on the map (ignoring other agents) from a location to an
+// endpoint, built once per pair by following the endpoint's h_val and shared
+// by every agent. Before searching, a planner tries the cached path started at
+// its current timestep: when it is collision-free and the goal can be held,
+// it is optimal and no search is needed.
+//
+// With a repair window, a cached path that collides is kept as the coarse
+// route: only a small space-time window around each collision is searched,
+// and the rest of the route is followed as is. Its arrival may be later than
+// the optimal one, but the search does not depend on the length of the route.
+class PathCache {
+public:
+  PathCache() : window(0), max_repairs(4), expanded(0), map_size(0), col(0) {}
+  void Set(int map_size, int col) {
+    this->map_size = map_size;
+    this->col = col;
+    paths.clear();
+  }
+
+  // returns the arrival timestep (-1 if the cached path collides with the
+  // agents other than ag_self and ag_hide or cannot hold the goal) and writes
+  // the path from begin_time on
+  int TryPath(int start_loc, int begin_time, const Endpoint &goal,
+              const Token &token, int ag_self, int ag_hide, PathView &path);
+  // same, searching around at most max_repairs collisions of the cached path
+  int RepairPath(int start_loc, int begin_time, const Endpoint &goal,
+                 const Token &token, int ag_self, int ag_hide, PathView &path);
+
+  int window;             // route cells (and extra timesteps) of a repair, 0: off
+  int max_repairs;        // repairs per path before giving up
+  unsigned long expanded; // states expanded by all the repairs
+
+private:
+  struct WindowNode {
+    int loc;
+    int timestep;
+    int parent; // index in nodes, -1 for the first one
+  };
+
+  // the cells from start_loc to goal (both included), empty if unreachable
+  const vector<loc_t> &Get(int start_loc, const Endpoint &goal);
+  // no agent other than ag_self and ag_hide is at goal after timestep from
+  bool CanHoldGoal(const Token &token, int ag_self, int ag_hide,
+                   const Endpoint &goal, int from) const;
+  // an agent other than ag_self and ag_hide is at to at timestep, or moves
+  // from to to from at the same time
+  bool IsBlocked(const Token &token, int ag_self, int ag_hide, int from, int to,
+                 int timestep) const;
+  // space-time search from (from, begin_time) to the route cell to by
+  // last_time, returns the arrival (-1 if none) and writes it to route
+  // (route[t - route_begin] = loc)
+  int SearchWindow(const Token &token, int ag_self, int ag_hide, int from,
+                   int begin_time, int to, int last_time, const Endpoint &goal,
+                   int route_begin);
+
+  int map_size;
+  int col;
+  unordered_map<uint64_t, vector<loc_t>> paths; // goal.id * map_size + start
+  // repair search
+  vector<WindowNode> nodes;
+  unordered_set<uint64_t> visited; // timestep * map_size + loc
+  vector<loc_t> route; // repaired path, copied to the agent once it is valid
+};
@@ -0,0 +1,65 @@
+#include "Planner.h"
+
+#include <stdexcept>
+
+namespace {
+
+// token passing
+class TokenPassing : public Planner {
+public:
+  void Run(Simulation &simu, bool verbose) { simu.run_TOTP(verbose); }
+};
+
+// token passing with task swaps
+class TokenPassingTaskSwap : public Planner {
+public:
+  void Run(Simulation &simu, bool verbose) { simu.run_TPTR(verbose); }
+};
+
+// one-step planning with priority inheritance and backtracking
+class PriorityInheritance : public Planner {
+public:
+  void Run(Simulation &simu, bool verbose) { simu.run_PIBT(verbose); }
+};
+
+template <class T> Planner *Make() { return new T(); }
+
+} // namespace
+
+const PlannerRegistry &PlannerRegistry::Instance() {
+  static PlannerRegistry registry;
+  if (registry.names.empty()) {
+    registry.Add("TP", "token passing", Make<TokenPassing>);
+    registry.Add("TPTS", "token passing with task swaps",
+                 Make<TokenPassingTaskSwap>);
+    registry.Add("PIBT", "one-step planning with priority inheritance",
+                 Make<PriorityInheritance>);
+  }
+  return registry;
+}
+
+void PlannerRegistry::Add(const string &name, const string &description,
+                          Factory factory) {
+  if (entries.count(name))
+    throw runtime_error("Planner " + name + " is registered twice");
+  Entry entry = {description, factory};
+  entries[name] = entry;
+  names.push_back(name);
+}
+
+unique_ptr<Planner> PlannerRegistry::Create(const string &name) const {
+  map<string, Entry>::const_iterator it = entries.find(name);
+  if (it == entries.end())
+    return unique_ptr<Planner>();
+  return unique_ptr<Planner>(it->second.factory());
+}
+
+string PlannerRegistry::Describe() const {
+  string s;
+  for (size_t i = 0; i < names.size(); i++) {
+    if (i > 0)
+      s += ", ";
+    s += names[i] + " (" + entries.find(names[i])->second.description + ")";
+  }
+  return s;
+}
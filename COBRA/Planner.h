@@ -0,0 +1,43 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Simulation.h"
+
+using namespace std;
+
+// A planning algorithm run on a loaded Simulation, which holds what planners
+// share: the map, tasks, heuristic tables, deadline and output.
+class Planner {
+public:
+  virtual ~Planner() {}
+  virtual void Run(Simulation &simu, bool verbose) = 0;
+};
+
+// Planners selected by name (the driver's --algorithm). A new planner is a
+// Planner subclass added to PlannerRegistry::Instance.
+class PlannerRegistry {
+public:
+  typedef Planner *(*Factory)();
+
+  // the registry with every built-in planner
+  static const PlannerRegistry &Instance();
+
+  void Add(const string &name, const string &description, Factory factory);
+  // NULL if name is not registered
+  unique_ptr<Planner> Create(const string &name) const;
+  // names in registration order
+  const vector<string> &Names() const { return names; }
+  // "name (description), ..." for the help message
+  string Describe() const;
+
+private:
+  struct Entry {
+    string description;
+    Factory factory;
+  };
+  map<string, Entry> entries;
+  vector<string> names;
+};
@@ -0,0 +1,369 @@
+#include "SIPP.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <queue>
+#include <unordered_set>
+
+void SIPP::Sync(const Token &token, int ag_self, int begin_time) {
+  int num_agents = token.path.size();
+  bool rebuild = this->token != &token || this->ag_self != ag_self ||
+                 begin_time < index_begin || synced > token.changed.size() ||
+                 synced < token.changed.oldest();
+  vector<bool> changed(num_agents, false);
+  int num_changed = 0;
+  for (size_t i = synced; i < token.changed.size() && !rebuild; i++) {
+    int ag = token.changed[i];
+    if (ag < 0)
+      rebuild = true; // Token::reset
+    else if (ag != ag_self && !changed[ag]) {
+      changed[ag] = true;
+      num_changed++;
+    }
+  }
+  synced = token.changed.size();
+  if (rebuild || 2 * num_changed > num_agents) {
+    this->token = &token;
+    this->ag_self = ag_self;
+    map_size = token.my_map.size();
+    col = token.col;
+    horizon = token.path[0].size();
+    index_begin = begin_time;
+    occupied.clear();
+    moves.clear();
+    agent_cells.assign(num_agents, vector<int>());
+    agent_moves.assign(num_agents, vector<uint64_t>());
+    for (int ag = 0; ag < num_agents; ag++)
+      AddAgent(ag);
+    tree_valid = false;
+  } else if (num_changed > 0) {
+    if (tree_begin != begin_time)
+      tree_valid = false; // its safe intervals start at tree_begin
+    dirty_cells.clear();
+    freed.clear();
+    vector<VisitKey> before, after, diff;
+    for (int ag = 0; ag < num_agents; ag++) {
+      if (!changed[ag])
+        continue;
+      if (!tree_valid) {
+        RemoveAgent(ag);
+        AddAgent(ag);
+        continue;
+      }
+      AgentVisits(ag, before);
+      RemoveAgent(ag);
+      AddAgent(ag);
+      AgentVisits(ag, after);
+      // paths pushed to Token::changed unchanged (restored) change nothing
+      diff.clear();
+      set_difference(before.begin(), before.end(), after.begin(), after.end(),
+                     back_inserter(diff));
+      size_t num_removed = diff.size();
+      set_difference(after.begin(), after.end(), before.begin(), before.end(),
+                     back_inserter(diff));
+      for (size_t i = 0; i < diff.size(); i++) {
+        if (diff[i].end < begin_time)
+          continue; // before the safe intervals
+        dirty_cells.push_back(diff[i].loc);
+        if (i < num_removed)
+          freed.push_back(diff[i]);
+      }
+    }
+    if (tree_valid && !dirty_cells.empty())
+      RepairTree();
+  }
+}
+
+void SIPP::AgentVisits(int ag, vector<VisitKey> &visits) const {
+  visits.clear();
+  for (size_t i = 0; i < agent_cells[ag].size(); i++) {
+    int loc = agent_cells[ag][i];
+    const vector<Visit> &cell = occupied.find(loc)->second;
+    for (size_t j = 0; j < cell.size(); j++) {
+      if (cell[j].ag == ag) {
+        VisitKey visit = {loc, cell[j].start, cell[j].end};
+        visits.push_back(visit);
+      }
+    }
+  }
+  // a cell visited several times is listed as often
+  sort(visits.begin(), visits.end());
+  visits.erase(unique(visits.begin(), visits.end()), visits.end());
+}
+
+void SIPP::RepairTree() {
+  if (marks.size() != (size_t)map_size) {
+    marks.assign(map_size, 0);
+    num_marks = 0;
+  }
+  num_marks++;
+  for (size_t i = 0; i < dirty_cells.size(); i++)
+    marks[dirty_cells[i]] = num_marks;
+  // a path using a visit freed at cell d leaves d at f - 1 at the earliest
+  // (f - 1 for the edge it blocked), f = max(its start, the time to reach d
+  // from the start), and reaches loc at f - 1 + |d - loc| (manhattan); with
+  // many freed visits only the earliest f is used
+  vector<pair<int, int>> reach; // (d, f - 1) of the visits still reachable
+  int earliest = horizon;
+  for (size_t i = 0; i < freed.size(); i++) {
+    int d = freed[i].loc;
+    int f = max(freed[i].start, tree_begin + abs(d % col - tree_start % col) +
+                                    abs(d / col - tree_start / col));
+    if (f <= freed[i].end) {
+      reach.push_back(make_pair(d, f - 1));
+      earliest = min(earliest, f - 1);
+    }
+  }
+  bool precise = reach.size() <= 64;
+
+  int action[4] = {1, -1, col, -col};
+  vector<int> index(states.size(), -1); // new index of the states kept
+  size_t n = 0;
+  for (size_t s = 0; s < states.size(); s++) {
+    State state = states[s];
+    int parent = state.parent < 0 ? -1 : index[state.parent];
+    bool keep = marks[state.loc] != num_marks &&
+                (state.parent < 0 || parent >= 0);
+    if (keep && state.parent >= 0 && state.arrive > earliest) {
+      if (!precise)
+        keep = false;
+      for (size_t i = 0; i < reach.size() && keep && precise; i++) {
+        int d = reach[i].first;
+        keep = state.arrive <= reach[i].second + abs(d % col - state.loc % col) +
+                                   abs(d / col - state.loc / col);
+      }
+    }
+    if (!keep) {
+      if (parent >= 0)
+        states[parent].expanded = false; // to generate its successors again
+      continue;
+    }
+    for (int i = 0; i < 4 && state.expanded; i++) {
+      if (marks[state.loc + action[i]] == num_marks)
+        state.expanded = false; // its successors there may change
+    }
+    state.parent = parent;
+    index[s] = n;
+    states[n++] = state;
+  }
+  states.resize(n);
+  best.clear();
+  for (size_t s = 0; s < n; s++)
+    best[StateKey(states[s].loc, states[s].safe)] = s;
+  if (n == 0 || index[0] < 0)
+    tree_valid = false; // the start changed
+}
+
+void SIPP::AddAgent(int ag) {
+  if (ag == ag_self || index_begin >= horizon)
+    return;
+  const PathView path = token->path[ag];
+  int loc = path[index_begin], start = index_begin;
+  for (int t = index_begin + 1; t <= horizon; t++) {
+    if (t < horizon && path[t] == loc)
+      continue;
+    Visit visit = {start, t - 1, ag};
+    vector<Visit> &visits = occupied[loc];
+    vector<Visit>::iterator it = visits.end();
+    while (it != visits.begin() && (it - 1)->start > start)
+      it--;
+    visits.insert(it, visit);
+    agent_cells[ag].push_back(loc);
+    if (t < horizon) {
+      uint64_t key = ((uint64_t)t * map_size + loc) * map_size + path[t];
+      moves.insert(make_pair(key, ag));
+      agent_moves[ag].push_back(key);
+      loc = path[t];
+      start = t;
+    }
+  }
+}
+
+void SIPP::RemoveAgent(int ag) {
+  for (size_t i = 0; i < agent_cells[ag].size(); i++) {
+    vector<Visit> &visits = occupied[agent_cells[ag][i]];
+    size_t n = 0;
+    for (size_t j = 0; j < visits.size(); j++) {
+      if (visits[j].ag != ag)
+        visits[n++] = visits[j];
+    }
+    visits.resize(n);
+  }
+  for (size_t i = 0; i < agent_moves[ag].size(); i++) {
+    pair<MoveMap::iterator, MoveMap::iterator> range =
+        moves.equal_range(agent_moves[ag][i]);
+    for (MoveMap::iterator it = range.first; it != range.second; it++) {
+      if (it->second == ag) {
+        moves.erase(it);
+        break;
+      }
+    }
+  }
+  agent_cells[ag].clear();
+  agent_moves[ag].clear();
+}
+
+int SIPP::FindPath(const Token &token, int ag_self, int ag_hide,
+                   int start_loc, int begin_time, const Endpoint &goal,
+                   PathView &path) {
+  if (goal.h_val[start_loc] < 0) // goal is unreachable
+    return -1;
+  Sync(token, ag_self, begin_time);
+  return Search(start_loc, begin_time, ag_hide, goal.loc, &goal.h_val, path);
+}
+
+int SIPP::FindEndpoint(const Token &token, int ag_self, int start_loc,
+                       int begin_time, PathView &path) {
+  Sync(token, ag_self, begin_time);
+  return Search(start_loc, begin_time, ag_self, -1, NULL, path);
+}
+
+void SIPP::SafeIntervals(int loc, vector<Interval> &safe) const {
+  safe.clear();
+  int start = begin_time;
+  unordered_map<int, vector<Visit>>::const_iterator it = occupied.find(loc);
+  if (it != occupied.end()) {
+    for (size_t i = 0; i < it->second.size(); i++) {
+      const Visit &visit = it->second[i];
+      if (visit.ag == ag_hide)
+        continue;
+      if (visit.start > start) {
+        Interval interval = {start, visit.start - 1};
+        safe.push_back(interval);
+      }
+      start = max(start, visit.end + 1);
+    }
+  }
+  if (start < horizon) {
+    Interval interval = {start, horizon - 1};
+    safe.push_back(interval);
+  }
+}
+
+int SIPP::Search(int start_loc, int begin_time, int ag_hide, int goal_loc,
+                 const vector<int> *h_val, PathView &path) {
+  if (begin_time >= horizon)
+    return -1;
+  this->ag_hide = ag_hide;
+  this->begin_time = begin_time;
+  unordered_set<int> task_goals; // endpoints that cannot be held
+  if (goal_loc < 0) {
+    for (list<Task *>::const_iterator it = token->tasks.begin();
+         it != token->tasks.end(); it++)
+      task_goals.insert((*it)->goal->loc);
+  }
+
+  // OPEN is ordered by f-val, then by larger arrival time (as Agent::AStar)
+  typedef pair<pair<int, int>, int> OpenEntry; // ((f-val, -arrive), state)
+  priority_queue<OpenEntry, vector<OpenEntry>, greater<OpenEntry>> open;
+  vector<Interval> safe;
+  int goal = -1;
+
+  bool reuse = h_val != NULL && tree_valid &&
+               tree_start == start_loc && tree_begin == begin_time &&
+               tree_hide == ag_hide;
+  if (reuse) {
+    // arrivals at expanded states are optimal whatever the (consistent)
+    // heuristic was, so only OPEN is reordered for the new goal
+    SafeIntervals(goal_loc, safe);
+    if (!safe.empty() && safe.back().end == horizon - 1) {
+      unordered_map<uint64_t, int>::iterator it =
+          best.find(StateKey(goal_loc, safe.back()));
+      if (it != best.end() && states[it->second].expanded)
+        goal = it->second;
+    }
+    for (unordered_map<uint64_t, int>::iterator it = best.begin();
+         goal < 0 && it != best.end(); it++) {
+      const State &s = states[it->second];
+      if (!s.expanded)
+        open.push(make_pair(make_pair(s.arrive + (*h_val)[s.loc], -s.arrive),
+                            it->second));
+    }
+  } else {
+    states.clear();
+    best.clear();
+    SafeIntervals(start_loc, safe);
+    State start = {start_loc, {begin_time, begin_time}, begin_time, -1, false};
+    for (size_t i = 0; i < safe.size(); i++) {
+      if (safe[i].start <= begin_time && begin_time <= safe[i].end)
+        start.safe = safe[i];
+    }
+    states.push_back(start);
+    best[StateKey(start_loc, start.safe)] = 0;
+    open.push(make_pair(
+        make_pair(begin_time + (h_val ? (*h_val)[start_loc] : 0), -begin_time),
+        0));
+    tree_valid = h_val != NULL;
+    tree_start = start_loc;
+    tree_begin = begin_time;
+    tree_hide = ag_hide;
+  }
+
+  int action[4] = {1, -1, col, -col};
+  while (goal < 0 && !open.empty()) {
+    int s = open.top().second;
+    open.pop();
+    State curr = states[s];
+    if (curr.expanded || best[StateKey(curr.loc, curr.safe)] != s)
+      continue; // reached earlier through another state
+
+    // the goal must be held until the end (the last safe interval)
+    if (curr.safe.end == horizon - 1) {
+      if (goal_loc >= 0 && curr.loc == goal_loc) {
+        goal = s;
+        break;
+      } else if (goal_loc < 0 && token->my_endpoints[curr.loc] &&
+                 curr.arrive < horizon - 1 &&
+                 task_goals.count(curr.loc) == 0) {
+        goal = s;
+        break;
+      }
+    }
+    states[s].expanded = true;
+    expanded++;
+    if (curr.arrive >= horizon - 1)
+      continue;
+
+    for (int i = 0; i < 4; i++) {
+      int next_loc = curr.loc + action[i];
+      if (!token->my_map[next_loc])
+        continue;
+      SafeIntervals(next_loc, safe);
+      for (size_t j = 0; j < safe.size(); j++) {
+        // leave curr.loc within its safe interval
+        if (safe[j].start > curr.safe.end + 1)
+          break;
+        if (safe[j].end < curr.arrive + 1)
+          continue;
+        int t = max(curr.arrive + 1, safe[j].start);
+        int last = min(safe[j].end, curr.safe.end + 1);
+        while (t <= last && IsMoveBlocked(curr.loc, next_loc, t))
+          t++; // edge collision, wait one more timestep
+        if (t > last)
+          continue;
+        uint64_t key = StateKey(next_loc, safe[j]);
+        unordered_map<uint64_t, int>::iterator it = best.find(key);
+        if (it != best.end() && states[it->second].arrive <= t)
+          continue;
+        State next = {next_loc, safe[j], t, s, false};
+        states.push_back(next);
+        best[key] = states.size() - 1;
+        open.push(make_pair(
+            make_pair(t + (h_val ? (*h_val)[next_loc] : 0), -t),
+            (int)states.size() - 1));
+      }
+    }
+  }
+  if (goal < 0)
+    return -1;
+
+  // wait at every cell until moving to the next one, then hold the goal
+  int end = horizon;
+  for (int s = goal; s >= 0; s = states[s].parent) {
+    for (int t = states[s].arrive; t < end; t++)
+      path[t] = states[s].loc;
+    end = states[s].arrive;
+  }
+  return states[goal].arrive;
+}
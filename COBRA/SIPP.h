@@ -0,0 +1,127 @@
+#pragma once
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include "Agent.h"
+
+using namespace std;
+
+// Safe interval path planning (Phillips and Likhachev, 2011) against the paths
+// in a Token. A cell is safe between the visits of other agents, so waiting is
+// one state per safe interval instead of one node per timestep. Same
+// constraints as Agent::AStar: vertex and edge collisions with every agent but
+// ag_self and ag_hide, and the goal must be held until the end of the horizon.
+//
+// Every agent keeps its own SIPP between calls. The index of the other agents'
+// visits is updated from Token::changed, re-reading only the paths of the
+// agents that planned since, and the search tree is kept while its start and
+// ag_hide stay the same, so the next goal resumes it. When visits change, only
+// the states at the cells whose visits changed are dropped, with the states
+// reached through them and those a freed cell could reach earlier; the states
+// next to these cells are expanded again.
+class SIPP {
+public:
+  SIPP()
+      : expanded(0), token(NULL), ag_self(-1), horizon(0), index_begin(0),
+        synced(0), tree_valid(false), num_marks(0) {}
+
+  // returns the earliest timestep at which goal is reached and can be held
+  // (-1 if none) and writes the path from begin_time on
+  int FindPath(const Token &token, int ag_self, int ag_hide, int start_loc,
+               int begin_time, const Endpoint &goal, PathView &path);
+  // same for the nearest endpoint that can be held and is not the goal of a
+  // task (Agent::Move2EP)
+  int FindEndpoint(const Token &token, int ag_self, int start_loc,
+                   int begin_time, PathView &path);
+
+  unsigned long expanded; // states expanded by all the searches
+
+private:
+  struct Interval {
+    int start, end; // [start, end]
+  };
+  struct Visit {
+    int start, end; // [start, end]
+    int ag;
+  };
+  struct VisitKey { // a visit of the agent being re-read
+    int loc, start, end;
+    bool operator<(const VisitKey &v) const {
+      return loc != v.loc ? loc < v.loc
+                          : start != v.start ? start < v.start : end < v.end;
+    }
+    bool operator==(const VisitKey &v) const {
+      return loc == v.loc && start == v.start && end == v.end;
+    }
+  };
+  struct State {
+    int loc;
+    Interval safe;
+    int arrive; // earliest arrival timestep in safe
+    int parent; // index in states, -1 for the start
+    bool expanded;
+  };
+
+  // brings the index up to date with token (paths from begin_time on)
+  void Sync(const Token &token, int ag_self, int begin_time);
+  void AddAgent(int ag);
+  void RemoveAgent(int ag);
+  // the visits of ag in the index, sorted
+  void AgentVisits(int ag, vector<VisitKey> &visits) const;
+  // drops the states of the tree that the changed visits may have made wrong
+  // or improvable (see the class comment), or the whole tree
+  void RepairTree();
+
+  // goal_loc < 0 searches for an endpoint
+  int Search(int start_loc, int begin_time, int ag_hide, int goal_loc,
+             const vector<int> *h_val, PathView &path);
+  void SafeIntervals(int loc, vector<Interval> &safe) const;
+  bool IsMoveBlocked(int from, int to, int timestep) const {
+    pair<MoveMap::const_iterator, MoveMap::const_iterator> range =
+        moves.equal_range(((uint64_t)timestep * map_size + to) * map_size +
+                          from);
+    for (MoveMap::const_iterator it = range.first; it != range.second; it++) {
+      if (it->second != ag_hide)
+        return true;
+    }
+    return false;
+  }
+  uint64_t StateKey(int loc, const Interval &safe) const {
+    return (uint64_t)safe.start * map_size + loc;
+  }
+
+  // index of the visits of the other agents
+  const Token *token;
+  int ag_self;
+  int map_size;
+  int col;
+  int horizon;     // number of timesteps of the paths (maxtime)
+  int index_begin; // visits are indexed from here on
+  size_t synced;   // entries of token->changed already applied
+  // visits of every cell, sorted by time
+  unordered_map<int, vector<Visit>> occupied;
+  // moves, (timestep * map_size + from) * map_size + to -> agent (several
+  // agents if their paths collide)
+  typedef unordered_multimap<uint64_t, int> MoveMap;
+  MoveMap moves;
+  vector<vector<int>> agent_cells;       // cells visited by every agent
+  vector<vector<uint64_t>> agent_moves; // moves of every agent
+
+  // current search
+  int ag_hide;
+  int begin_time;
+  // search tree of the last FindPath
+  bool tree_valid;
+  int tree_start;
+  int tree_begin;
+  int tree_hide;
+  vector<State> states;
+  unordered_map<uint64_t, int> best; // state key -> index in states
+  // visits that changed since the tree was searched: cells, and the visits
+  // removed (the cell may be free from their start on)
+  vector<int> dirty_cells;
+  vector<VisitKey> freed;
+  vector<unsigned int> marks; // per cell, num_marks if dirty
+  unsigned int num_marks;
+};
@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <ctime>
 #include <iostream>
+#include <stdexcept>
 
 #include "Agent.h"
 #include "Simulation.h"
@@ -11,8 +12,12 @@ Simulation::Simulation(string map_name, string task_name,
     : deadline_time(deadline_time), debug(debug) {
   computation_time = 0;
   num_computations = 0;
+  chains_exhausted = 0;
+  snapshot_ms = 0;
+  num_snapshots = 0;
   LoadMap(map_name);
   LoadTask(task_name);
+  loaded.Take(token, task_by_id);
   if (debug) {
     SaveDebugInfo("debug.txt");
   }
@@ -71,10 +76,15 @@ void Simulation::LoadMap(string fname) {
   getline(myfile, line);
   ss << line;
   ss >> maxtime; // max timestep
+  if (row * col - 1 > numeric_limits<loc_t>::max())
+    throw runtime_error("Map has more cells than loc_t can address (build "
+                        "without COBRA_LOC16).");
   // resize all vectors
   agents.resize(agent_num);
-  token.agents.resize(agent_num);
-  token.path.resize(agent_num);
+  token.ag_loc.resize(agent_num);
+  token.ag_finish_time.resize(agent_num);
+  token.path.resize(agent_num, maxtime);
+  token.col = col;
   endpoints.resize(workpoint_num + agent_num);
   token.my_map.resize(row * col);
   token.my_endpoints.resize(row * col);
@@ -96,12 +106,7 @@ void Simulation::LoadMap(string fname) {
                  'r') // robot initial location, also regarded as home endpoint
       {
         endpoints[workpoint_num + ag].loc = i * col + j;
-        agents[ag].Set(i * col + j, col, row, ag, maxtime);
-        token.agents[ag] = &agents[ag];
-        token.path[ag].resize(maxtime);
-        for (unsigned int k = 0; k < maxtime; k++) {
-          token.path[ag][k] = i * col + j;
-        }
+        agents[ag].Set(ag, i * col + j, token);
         ag++;
       }
     }
@@ -123,8 +128,8 @@ void Simulation::LoadMap(string fname) {
   }
 
   // initial heuristic matrix for each endpoint
+  Endpoint::SetHVals(endpoints, token.my_map, col);
   for (unsigned int e = 0; e < endpoints.size(); e++) {
-    endpoints[e].SetHVal(token.my_map, col);
     endpoints[e].id = e;
     /*
     cout << "Endpoint " << e << endl;
@@ -158,7 +163,7 @@ void Simulation::LoadTask(string fname) {
   ss >> task_num; // number of tasks
   tasks.resize(maxtime);
   for (int i = 0; i < task_num; i++) {
-    int s, g, ts, tg, aid;
+    int s, g, ts, tg, aid = -1; // aid is optional (-1: task is not bound to an agent)
     getline(myfile, line);
     ss.clear();
     ss << line;
@@ -167,6 +172,12 @@ void Simulation::LoadTask(string fname) {
     tasks[t_task].push_back(Task(i, &endpoints[s], &endpoints[g], ts, tg, aid));
   }
   myfile.close();
+  task_by_id.resize(task_num);
+  for (unsigned int i = 0; i < tasks.size(); i++) {
+    for (list<Task>::iterator it = tasks[i].begin(); it != tasks[i].end();
+         it++)
+      task_by_id[it->id] = &(*it);
+  }
 
   if (!tasks[0].empty()) {
     for (list<Task>::iterator it = tasks[0].begin(); it != tasks[0].end();
@@ -197,6 +208,90 @@ void Simulation::LoadTask(string fname) {
   */
 }
 
+void Simulation::UseSIPP(bool sipp) {
+  planners.assign(sipp ? agents.size() : 0, SIPP());
+  for (unsigned int i = 0; i < agents.size(); i++)
+    agents[i].sipp = sipp ? &planners[i] : NULL;
+}
+
+void Simulation::UsePathCache(bool use, int window) {
+  path_cache.Set(row * col, col);
+  path_cache.window = window;
+  for (unsigned int i = 0; i < agents.size(); i++)
+    agents[i].path_cache = use ? &path_cache : NULL;
+}
+
+void Simulation::LimitChains(unsigned int max_depth,
+                             unsigned long max_expansions) {
+  token.chain.max_depth = max_depth;
+  token.chain.max_expansions = max_expansions;
+}
+
+void Simulation::SnapshotSlowPasses(double ms, const string &prefix) {
+  snapshot_ms = ms;
+  snapshot_prefix = prefix;
+}
+
+void Simulation::SaveSlowPass(bool tptr, int ag, Time::time_point start) {
+  double ms =
+      std::chrono::duration<double, std::milli>(Time::now() - start).count();
+  if (ms <= snapshot_ms)
+    return;
+  snapshot.tptr = tptr;
+  snapshot.agent = ag;
+  snapshot.ms = ms;
+  snapshot.sipp = !planners.empty();
+  snapshot.path_cache = !agents.empty() && agents[0].path_cache != NULL;
+  snapshot.window = path_cache.window;
+  snapshot.max_depth = token.chain.max_depth;
+  snapshot.max_expansions = token.chain.max_expansions;
+  string fname = snapshot_prefix + "-" + to_string(num_snapshots++) + ".snap";
+  snapshot.Save(fname);
+  cerr << (tptr ? "TPTR" : "TOTP") << " pass of agent " << ag
+       << " at Timestep " << snapshot.timestep << " took " << ms
+       << " ms, saved to " << fname << endl;
+}
+
+void Simulation::Reset() {
+  loaded.Restore(token, task_by_id, agents);
+  computation_time = 0;
+  num_computations = 0;
+  chain_lengths.clear();
+  chains_exhausted = 0;
+}
+
+double Simulation::Replay(const string &fname, int repeat, bool verbose) {
+  Snapshot snap;
+  snap.Load(fname);
+  if (snap.agent < 0 || snap.agent >= (int)agents.size())
+    throw runtime_error("Snapshot was taken on another instance.");
+  UseSIPP(snap.sipp);
+  UsePathCache(snap.path_cache, snap.window);
+  LimitChains(snap.max_depth, snap.max_expansions);
+  double total = 0;
+  for (int i = 0; i < repeat; i++) {
+    snap.Restore(token, task_by_id, agents);
+    Agent *ag = &agents[snap.agent];
+    token.chain.Start();
+    Time::time_point start = Time::now();
+    if (snap.tptr)
+      ag->TPTR(token, verbose);
+    else
+      ag->TOTP(token, verbose);
+    total +=
+        std::chrono::duration<double, std::milli>(Time::now() - start).count();
+    token.changed.push_back(ag->id);
+  }
+  end_timestep = token.timestep;
+  double mean = repeat > 0 ? total / repeat : 0;
+  cout << (snap.tptr ? "TPTR" : "TOTP") << " pass of agent " << snap.agent
+       << " at Timestep " << snap.timestep << ": " << snap.ms
+       << " ms when saved, " << mean << " ms replayed (" << repeat
+       << " runs, " << token.chain.expansions << " expansions in the last)"
+       << endl;
+  return mean;
+}
+
 double Simulation::elapsed_ms() const {
   return std::chrono::duration_cast<std::chrono::milliseconds>(Time::now() -
                                                                t_s)
@@ -220,18 +315,20 @@ void Simulation::run_TOTP(bool verbose) {
     }
 
     // pick of  the first agent in the waiting line
-    Agent *ag = &agents[0];
+    const unsigned int *finish_time = token.ag_finish_time.data();
+    int next = 0;
     for (int i = 1; i < agents.size(); i++) {
-      if (agents[i].finish_time == token.timestep) {
-        ag = &agents[i];
+      if (finish_time[i] == token.timestep) {
+        next = i;
         break;
-      } else if (agents[i].finish_time < ag->finish_time) {
-        ag = &agents[i];
+      } else if (finish_time[i] < finish_time[next]) {
+        next = i;
       }
     }
+    Agent *ag = &agents[next];
 
     // add new tasks
-    for (unsigned int i = token.timestep + 1; i <= ag->finish_time; i++) {
+    for (unsigned int i = token.timestep + 1; i <= finish_time[next]; i++) {
       if (tasks[i].empty())
         continue;
       for (list<Task>::iterator it = tasks[i].begin(); it != tasks[i].end();
@@ -244,8 +341,8 @@ void Simulation::run_TOTP(bool verbose) {
       }
     }
     // update timestep
-    token.timestep = ag->finish_time;
-    ag->loc = ag->path[token.timestep];
+    token.timestep = finish_time[next];
+    token.ag_loc[next] = ag->path[token.timestep];
     if (verbose) {
       cout << "Timestep: " << token.timestep << endl;
       PrintPathUntilTimestep(token.timestep + 1);
@@ -276,7 +373,7 @@ void Simulation::run_TOTP(bool verbose) {
 
     if (token.tasks.empty()) // If no new tasks
     {
-      ag->finish_time = ag->finish_time + 1; // agent waits for one timestep
+      token.ag_finish_time[next]++; // agent waits for one timestep
       continue;
     }
 
@@ -289,6 +386,11 @@ void Simulation::run_TOTP(bool verbose) {
     if (i == endpoints.size()) system("PAUSE");*/
     //***************end test***************
     num_computations++;
+    Time::time_point pass_start;
+    if (snapshot_ms > 0) {
+      snapshot.Take(token, task_by_id);
+      pass_start = Time::now();
+    }
     clock_t start = std::clock();
     if (!ag->TOTP(token, verbose)) // not get a task
     {
@@ -297,6 +399,9 @@ void Simulation::run_TOTP(bool verbose) {
       // system("PAUSE");
     }
     computation_time += std::clock() - start;
+    if (snapshot_ms > 0)
+      SaveSlowPass(false, ag->id, pass_start);
+    token.changed.push_back(ag->id);
     /*if (!TestConstraints())
     {
             system("PAUSE");
@@ -320,17 +425,19 @@ void Simulation::run_TPTR(bool verbose) {
       break;
     }
     // pick off the first agent in the waiting line
-    Agent *ag = &agents[0];
+    const unsigned int *finish_time = token.ag_finish_time.data();
+    int next = 0;
     for (int i = 1; i < agents.size(); i++) {
-      if (agents[i].finish_time == token.timestep) {
-        ag = &agents[i];
+      if (finish_time[i] == token.timestep) {
+        next = i;
         break;
-      } else if (agents[i].finish_time < ag->finish_time) {
-        ag = &agents[i];
+      } else if (finish_time[i] < finish_time[next]) {
+        next = i;
       }
     }
+    Agent *ag = &agents[next];
     // add new tasks to token
-    for (unsigned int i = token.timestep + 1; i <= ag->finish_time; i++) {
+    for (unsigned int i = token.timestep + 1; i <= finish_time[next]; i++) {
       if (tasks[i].empty())
         continue;
       for (list<Task>::iterator it = tasks[i].begin(); it != tasks[i].end();
@@ -343,8 +450,8 @@ void Simulation::run_TPTR(bool verbose) {
       }
     }
     // update timestep
-    token.timestep = ag->finish_time;
-    ag->loc = ag->path[token.timestep];
+    token.timestep = finish_time[next];
+    token.ag_loc[next] = ag->path[token.timestep];
     if (verbose) {
       cout << "Timestep: " << token.timestep << endl;
       PrintPathUntilTimestep(token.timestep + 1);
@@ -414,7 +521,13 @@ void Simulation::run_TPTR(bool verbose) {
     if (i == endpoints.size()) system("PAUSE");*/
     //**************end test**********************
     num_computations++;
+    Time::time_point pass_start;
+    if (snapshot_ms > 0) {
+      snapshot.Take(token, task_by_id);
+      pass_start = Time::now();
+    }
     clock_t start = std::clock();
+    token.chain.Start();
     if (!ag->TPTR(token, verbose)) // not get a task
     {
       if (verbose)
@@ -422,6 +535,14 @@ void Simulation::run_TPTR(bool verbose) {
       // system("PAUSE");
     }
     computation_time += std::clock() - start;
+    if (snapshot_ms > 0)
+      SaveSlowPass(true, ag->id, pass_start);
+    token.changed.push_back(ag->id);
+    if (chain_lengths.size() <= token.chain.longest)
+      chain_lengths.resize(token.chain.longest + 1, 0);
+    chain_lengths[token.chain.longest]++;
+    if (token.chain.exhausted)
+      chains_exhausted++;
     /*if (!TestConstraints())
     {
             system("PAUSE");
@@ -429,6 +550,82 @@ void Simulation::run_TPTR(bool verbose) {
   }
 }
 
+void Simulation::run_PIBT(bool verbose) {
+  if (verbose)
+    cout << endl << "************PIBT************" << endl;
+
+  t_s = Time::now();
+
+  vector<Endpoint *> home(agents.size());
+  for (unsigned int i = 0; i < agents.size(); i++)
+    home[i] = &endpoints[workpoint_num + i];
+  PIBT pibt;
+  pibt.Set(token, agents, home);
+
+  while ((!token.tasks.empty() || pibt.Busy() || token.timestep <= t_task) &&
+         token.timestep + 1 < maxtime) {
+    if (elapsed_ms() > deadline_time) {
+      end_timestep = token.timestep;
+      if (end_timestep == 0)
+        end_timestep = 1;
+      if (verbose)
+        cerr << "Deadline reached." << endl;
+      break;
+    }
+    if (verbose) {
+      cout << "Timestep: " << token.timestep << endl;
+      PrintPathUntilTimestep(token.timestep + 1);
+      PrintTaskUntilTimestep(token.timestep + 20);
+    }
+
+    if (token.timestep > 0) {
+      end_timestep = token.timestep;
+      break;
+    }
+
+    // every agent moves one timestep
+    num_computations++;
+    clock_t start = std::clock();
+    pibt.Step(token, verbose);
+    computation_time += std::clock() - start;
+
+    // update timestep and add new tasks to token
+    token.timestep++;
+    for (unsigned int i = 0; i < agents.size(); i++)
+      token.ag_loc[i] = agents[i].path[token.timestep];
+    for (list<Task>::iterator it = tasks[token.timestep].begin();
+         it != tasks[token.timestep].end(); it++) {
+      if (it->aid == -1) {
+        token.tasks.push_back(&(*it));
+      } else {
+        token.ag_tasks[it->aid].push_back(&(*it));
+      }
+    }
+  }
+  // agents hold their last location
+  for (unsigned int i = 0; i < agents.size(); i++) {
+    for (unsigned int t = token.timestep + 1; t < maxtime; t++)
+      agents[i].path[t] = agents[i].path[token.timestep];
+  }
+  token.changed.push_back(-1);
+}
+
+int Simulation::Improve(unsigned int neighborhood_size, bool verbose) {
+  // the task every agent is doing
+  vector<Task *> ag_task(agents.size(), NULL);
+  for (unsigned int i = 0; i < tasks.size(); i++) {
+    for (list<Task>::iterator it = tasks[i].begin(); it != tasks[i].end();
+         it++) {
+      if (it->state == TAKEN && it->ag_arrive_goal > token.timestep)
+        ag_task[it->ag->id] = &(*it);
+    }
+  }
+  LNS lns;
+  lns.neighborhood_size = neighborhood_size;
+  return lns.Run(token, agents, ag_task, deadline_time - elapsed_ms(),
+                 verbose);
+}
+
 void Simulation::ShowTask() {
   unsigned int WaitingTime = 0;
   unsigned int LastFinish = 0;
@@ -525,6 +722,26 @@ void Simulation::SaveThroughput(const string &fname) {
   fout.close();
 }
 
+void Simulation::SaveChains(const string &fname) {
+  // write output file
+  std::ofstream fout(fname);
+  if (!fout)
+    return;
+  int passes = 0;
+  long robberies = 0;
+  for (unsigned int i = 0; i < chain_lengths.size(); i++) {
+    passes += chain_lengths[i];
+    robberies += (long)i * chain_lengths[i];
+  }
+  fout << "passes " << passes << endl;
+  fout << "exhausted " << chains_exhausted << endl;
+  fout << "mean " << (passes > 0 ? (double)robberies / passes : 0.0) << endl;
+  // number of passes whose longest chain had i robberies
+  for (unsigned int i = 0; i < chain_lengths.size(); i++)
+    fout << i << " " << chain_lengths[i] << endl;
+  fout.close();
+}
+
 void Simulation::SavePath(const string &fname) {
   // write output file
   std::ofstream fout(fname);
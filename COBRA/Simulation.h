@@ -17,6 +17,11 @@
 
 #include "Agent.h"
 #include "Endpoint.h"
+#include "LNS.h"
+#include "PathCache.h"
+#include "PIBT.h"
+#include "SIPP.h"
+#include "Snapshot.h"
 
 using namespace std;
 using Time = std::chrono::steady_clock;
@@ -26,9 +31,30 @@ public:
   Simulation(string map_name, string task_name, unsigned int deadline_time, bool debug);
   ~Simulation();
 
+  // plan with safe intervals (SIPP) instead of the space-time AStar
+  void UseSIPP(bool sipp);
+  // try cached shortest paths between endpoints before searching, and repair
+  // their collisions within window cells of them (0: no repair)
+  void UsePathCache(bool use, int window);
+  // bound the task-robbing chains of TPTR (0: unbounded)
+  void LimitChains(unsigned int max_depth, unsigned long max_expansions);
+  // save the state before every TOTP or TPTR pass that takes more than ms to
+  // prefix-<n>.snap (0: never)
+  void SnapshotSlowPasses(double ms, const string &prefix);
+  // back to the state after loading (token, tasks and statistics), to run
+  // another planner on the same instance
+  void Reset();
+  // runs the pass of a snapshot repeat times from its state, with the planner
+  // settings it was taken with, returns its mean time in ms
+  double Replay(const string &fname, int repeat, bool verbose);
+
   // run
   void run_TOTP(bool verbose);
   void run_TPTR(bool verbose);
+  void run_PIBT(bool verbose);
+  // improves the paths with the time left before the deadline (LNS of
+  // neighborhood_size agents), returns the reduction of the sum of arrivals
+  int Improve(unsigned int neighborhood_size, bool verbose);
 
   // save
   void ShowTask();
@@ -39,6 +65,7 @@ public:
   void SaveTaskUntilTimestep(const string &fname, const int timestep);
   void PrintTaskUntilTimestep(const int timestep);
   void SaveThroughput(const string &fname);
+  void SaveChains(const string &fname);
 
   unsigned int deadline_time;
   bool debug;
@@ -52,6 +79,8 @@ private:
   void LoadTask(string fname);
   double elapsed_ms() const;
   void SaveDebugInfo(const string &fname);
+  // saves the snapshot if the pass that started at start was slow
+  void SaveSlowPass(bool tptr, int ag, Time::time_point start);
   // test
   bool TestConstraints();
 
@@ -62,6 +91,16 @@ private:
   vector<list<Task>> tasks;
   vector<Endpoint> endpoints;
   vector<Agent> agents;
+  PathCache path_cache;
+  vector<SIPP> planners; // SIPP of every agent
+  vector<int> chain_lengths; // TPTR passes by longest robbing chain
+  int chains_exhausted;      // TPTR passes that ran out of expansions
+  vector<Task *> task_by_id;
+  Snapshot loaded;           // the state after loading
+  Snapshot snapshot;         // the state before the current pass
+  double snapshot_ms;        // 0: no snapshots
+  string snapshot_prefix;
+  int num_snapshots;
 
   unsigned int maxtime;
 
@@ -0,0 +1,218 @@
+#include "Snapshot.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <stdint.h>
+
+namespace {
+
+const char kMagic[8] = {'C', 'O', 'B', 'R', 'A', 'S', 'N', 'P'};
+const uint32_t kVersion = 1;
+
+template <class T> void Write(ofstream &out, T value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <class T> T Read(ifstream &in) {
+  T value;
+  if (!in.read(reinterpret_cast<char *>(&value), sizeof(value)))
+    throw runtime_error("Snapshot file is truncated.");
+  return value;
+}
+
+void WriteIds(ofstream &out, const vector<int> &ids) {
+  Write<uint32_t>(out, ids.size());
+  for (size_t i = 0; i < ids.size(); i++)
+    Write<int32_t>(out, ids[i]);
+}
+
+// ids must be below end
+void ReadIds(ifstream &in, vector<int> &ids, size_t end) {
+  ids.resize(Read<uint32_t>(in));
+  for (size_t i = 0; i < ids.size(); i++) {
+    ids[i] = Read<int32_t>(in);
+    if (ids[i] < 0 || (size_t)ids[i] >= end)
+      throw runtime_error("Snapshot file has a broken task list.");
+  }
+}
+
+void CopyPath(const Token &token, int ag, unsigned int horizon,
+              vector<loc_t> &path) {
+  const PathView view = token.path[ag];
+  for (unsigned int t = 0; t < horizon; t++)
+    path[ag * horizon + t] = view[t];
+}
+
+} // namespace
+
+void Snapshot::Take(const Token &token, const vector<Task *> &task_by_id) {
+  bool all = num_agents != token.path.size() ||
+             synced > token.changed.size() || synced < token.changed.oldest();
+  num_agents = token.path.size();
+  horizon = token.path[0].size();
+  path.resize(num_agents * horizon);
+  for (size_t i = synced; i < token.changed.size() && !all; i++)
+    all = token.changed[i] < 0;
+  if (all) {
+    for (unsigned int ag = 0; ag < num_agents; ag++)
+      CopyPath(token, ag, horizon, path);
+  } else {
+    for (size_t i = synced; i < token.changed.size(); i++)
+      CopyPath(token, token.changed[i], horizon, path);
+  }
+  synced = token.changed.size();
+
+  ag_loc = token.ag_loc;
+  ag_finish_time = token.ag_finish_time;
+  timestep = token.timestep;
+  task_state.resize(task_by_id.size());
+  for (size_t id = 0; id < task_by_id.size(); id++) {
+    const Task *t = task_by_id[id];
+    SavedTask s = {t->state, t->ag != NULL ? t->ag->id : -1,
+                   t->ag_arrive_start, t->ag_arrive_goal};
+    task_state[id] = s;
+  }
+  open.clear();
+  for (list<Task *>::const_iterator it = token.tasks.begin();
+       it != token.tasks.end(); it++)
+    open.push_back((*it)->id);
+  ag_open.resize(num_agents);
+  for (unsigned int ag = 0; ag < num_agents; ag++) {
+    ag_open[ag].clear();
+    for (list<Task *>::const_iterator it = token.ag_tasks[ag].begin();
+         it != token.ag_tasks[ag].end(); it++)
+      ag_open[ag].push_back((*it)->id);
+  }
+}
+
+void Snapshot::Restore(Token &token, const vector<Task *> &task_by_id,
+                       vector<Agent> &agents) const {
+  if (num_agents != agents.size() || horizon != token.path[0].size() ||
+      task_state.size() != task_by_id.size())
+    throw runtime_error("Snapshot was taken on another instance.");
+  for (unsigned int ag = 0; ag < num_agents; ag++) {
+    PathView view = token.path[ag];
+    for (unsigned int t = 0; t < horizon; t++)
+      view[t] = path[ag * horizon + t];
+  }
+  token.changed.push_back(-1);
+  token.ag_loc = ag_loc;
+  token.ag_finish_time = ag_finish_time;
+  token.timestep = timestep;
+  for (size_t id = 0; id < task_by_id.size(); id++) {
+    Task *t = task_by_id[id];
+    const SavedTask &s = task_state[id];
+    t->state = (TaskState)s.state;
+    t->ag = s.ag >= 0 ? &agents[s.ag] : NULL;
+    t->ag_arrive_start = s.ag_arrive_start;
+    t->ag_arrive_goal = s.ag_arrive_goal;
+  }
+  token.tasks.clear();
+  for (size_t i = 0; i < open.size(); i++)
+    token.tasks.push_back(task_by_id[open[i]]);
+  for (unsigned int ag = 0; ag < num_agents; ag++) {
+    token.ag_tasks[ag].clear();
+    for (size_t i = 0; i < ag_open[ag].size(); i++)
+      token.ag_tasks[ag].push_back(task_by_id[ag_open[ag][i]]);
+  }
+}
+
+void Snapshot::Save(const string &fname) const {
+  ofstream out(fname.c_str(), ios::binary);
+  if (!out.is_open())
+    throw runtime_error("Cannot write snapshot " + fname + ".");
+  out.write(kMagic, sizeof(kMagic));
+  Write<uint32_t>(out, kVersion);
+  Write<uint8_t>(out, tptr);
+  Write<int32_t>(out, agent);
+  Write<uint32_t>(out, timestep);
+  Write<double>(out, ms);
+  Write<uint8_t>(out, sipp);
+  Write<uint8_t>(out, path_cache);
+  Write<int32_t>(out, window);
+  Write<uint32_t>(out, max_depth);
+  Write<uint64_t>(out, max_expansions);
+
+  Write<uint32_t>(out, num_agents);
+  Write<uint32_t>(out, horizon);
+  for (unsigned int ag = 0; ag < num_agents; ag++) {
+    Write<uint32_t>(out, ag_loc[ag]);
+    Write<uint32_t>(out, ag_finish_time[ag]);
+    // runs of (loc, length)
+    const loc_t *p = path.data() + ag * horizon;
+    for (unsigned int t = 0; t < horizon;) {
+      unsigned int run = 1;
+      while (t + run < horizon && p[t + run] == p[t])
+        run++;
+      Write<uint32_t>(out, p[t]);
+      Write<uint32_t>(out, run);
+      t += run;
+    }
+  }
+  Write<uint32_t>(out, task_state.size());
+  for (size_t id = 0; id < task_state.size(); id++) {
+    Write<uint8_t>(out, task_state[id].state);
+    Write<int32_t>(out, task_state[id].ag);
+    Write<uint32_t>(out, task_state[id].ag_arrive_start);
+    Write<uint32_t>(out, task_state[id].ag_arrive_goal);
+  }
+  WriteIds(out, open);
+  for (unsigned int ag = 0; ag < num_agents; ag++)
+    WriteIds(out, ag_open[ag]);
+  if (!out)
+    throw runtime_error("Cannot write snapshot " + fname + ".");
+}
+
+void Snapshot::Load(const string &fname) {
+  ifstream in(fname.c_str(), ios::binary);
+  if (!in.is_open())
+    throw runtime_error("Snapshot " + fname + " not found.");
+  char magic[sizeof(kMagic)];
+  if (!in.read(magic, sizeof(magic)) ||
+      memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      Read<uint32_t>(in) != kVersion)
+    throw runtime_error(fname + " is not a snapshot of this version.");
+  tptr = Read<uint8_t>(in);
+  agent = Read<int32_t>(in);
+  timestep = Read<uint32_t>(in);
+  ms = Read<double>(in);
+  sipp = Read<uint8_t>(in);
+  path_cache = Read<uint8_t>(in);
+  window = Read<int32_t>(in);
+  max_depth = Read<uint32_t>(in);
+  max_expansions = Read<uint64_t>(in);
+
+  num_agents = Read<uint32_t>(in);
+  horizon = Read<uint32_t>(in);
+  ag_loc.resize(num_agents);
+  ag_finish_time.resize(num_agents);
+  path.resize(num_agents * horizon);
+  for (unsigned int ag = 0; ag < num_agents; ag++) {
+    ag_loc[ag] = Read<uint32_t>(in);
+    ag_finish_time[ag] = Read<uint32_t>(in);
+    loc_t *p = path.data() + ag * horizon;
+    for (unsigned int t = 0; t < horizon;) {
+      loc_t loc = Read<uint32_t>(in);
+      unsigned int run = Read<uint32_t>(in);
+      if (run == 0 || t + run > horizon)
+        throw runtime_error(fname + " has a broken path.");
+      fill(p + t, p + t + run, loc);
+      t += run;
+    }
+  }
+  task_state.resize(Read<uint32_t>(in));
+  for (size_t id = 0; id < task_state.size(); id++) {
+    task_state[id].state = Read<uint8_t>(in);
+    task_state[id].ag = Read<int32_t>(in);
+    if (task_state[id].ag < -1 || task_state[id].ag >= (int)num_agents)
+      throw runtime_error(fname + " has a broken task.");
+    task_state[id].ag_arrive_start = Read<uint32_t>(in);
+    task_state[id].ag_arrive_goal = Read<uint32_t>(in);
+  }
+  ReadIds(in, open, task_state.size());
+  ag_open.resize(num_agents);
+  for (unsigned int ag = 0; ag < num_agents; ag++)
+    ReadIds(in, ag_open[ag], task_state.size());
+  synced = 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "Agent.h"
+
+using namespace std;
+
+// The state of the token right before one token pass (TOTP or TPTR of one
+// agent), so that a pass that took too long can be run again alone, e.g. under
+// a profiler. The map and the tasks are not saved: the snapshot is restored
+// into a Simulation loaded from the same instance.
+//
+// The file is binary, in the byte order of the machine: the paths are
+// run-length encoded, since agents mostly hold their goals or wait.
+class Snapshot {
+public:
+  Snapshot() : tptr(false), agent(-1), timestep(0), ms(0), sipp(false),
+               path_cache(false), window(0), max_depth(0), max_expansions(0),
+               num_agents(0), horizon(0), synced(0) {}
+
+  // copies the token and the tasks (task_by_id[id]) before a pass; only the
+  // paths changed since the last call (token.changed) are copied again
+  void Take(const Token &token, const vector<Task *> &task_by_id);
+  // writes the state back into the token, the tasks and their agents
+  void Restore(Token &token, const vector<Task *> &task_by_id,
+               vector<Agent> &agents) const;
+
+  // throw runtime_error if the file cannot be written or read
+  void Save(const string &fname) const;
+  void Load(const string &fname);
+
+  // the pass
+  bool tptr;           // TPTR, else TOTP
+  int agent;           // the agent holding the token
+  unsigned int timestep;
+  double ms;           // how long it took when it was taken
+  // the planner settings
+  bool sipp;
+  bool path_cache;
+  int window;
+  unsigned int max_depth;
+  unsigned long max_expansions;
+
+  unsigned int num_agents;
+  unsigned int horizon;
+
+private:
+  struct SavedTask {
+    int state;
+    int ag; // id of Task::ag, -1 for none
+    unsigned int ag_arrive_start;
+    unsigned int ag_arrive_goal;
+  };
+
+  vector<loc_t> path; // path[ag * horizon + time]
+  vector<loc_t> ag_loc;
+  vector<unsigned int> ag_finish_time;
+  vector<SavedTask> task_state; // by task id
+  vector<int> open;             // ids of token.tasks, in order
+  vector<vector<int>> ag_open;  // ids of token.ag_tasks, in order
+  size_t synced;                // entries of token.changed already copied
+};
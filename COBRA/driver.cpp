@@ -1,3 +1,4 @@
+#include "Planner.h"
 #include "Simulation.h"
 // #include <algorithm>
 #include <boost/program_options.hpp>
@@ -20,25 +21,64 @@ void validate_string(const boost::any &v, const vector<string> &valid_strings) {
 int main(int argc, char **argv) {
   try {
     po::options_description desc("Allowed options");
-    vector<string> valid_algorithms = {"TP", "TPTS"};
-    string algorithm;
+    const PlannerRegistry &planners = PlannerRegistry::Instance();
+    const vector<string> &valid_algorithms = planners.Names();
+    vector<string> algorithms;
 
     desc.add_options()("help", "produce help message")(
         "map,m", po::value<string>()->required(), "input file for map")(
         "task,t", po::value<string>()->required(),
         "input file for task")("algorithm,a",
-                               po::value<string>(&algorithm)
-                                   ->default_value("TP")
-                                   ->notifier([&](const string &val) {
-                                     validate_string(val, valid_algorithms);
+                               po::value<vector<string>>(&algorithms)
+                                   ->multitoken()
+                                   ->default_value(vector<string>(1, "TP"),
+                                                   "TP")
+                                   ->notifier([&](const vector<string> &vals) {
+                                     for (size_t i = 0; i < vals.size(); i++)
+                                       validate_string(vals[i],
+                                                       valid_algorithms);
                                    }),
-                               "algorithm to use (TP or TPTS)")(
+                               ("algorithm to use: " + planners.Describe() +
+                                "; several run one after the other on the "
+                                "loaded state, each output file then gets "
+                                "the name of the algorithm as a suffix")
+                                   .c_str())(
         "deadline,l", po::value<unsigned int>()->default_value(1000),
         "deadline for the simulation in ms")(
         "output-path,p", po::value<string>()->default_value("path.txt"),
         "output path file")("output-task,k",
                             po::value<string>()->default_value("task.txt"),
                             "output task file")(
+        "sipp", po::bool_switch()->default_value(false),
+        "plan with safe intervals (SIPP) instead of space-time A*")(
+        "path-cache", po::bool_switch()->default_value(false),
+        "try cached shortest paths between endpoints before searching")(
+        "repair-window", po::value<unsigned int>()->default_value(0),
+        "with --path-cache, search only this many cells of a colliding "
+        "cached path (and as many extra timesteps) around each collision "
+        "before a full search (0: off)")(
+        "max-swap-depth", po::value<unsigned int>()->default_value(0),
+        "maximum number of task robberies in a chain of TPTS (0: unbounded)")(
+        "max-expansions", po::value<unsigned long>()->default_value(0),
+        "maximum number of search expansions per token pass of TPTS (0: "
+        "unbounded)")(
+        "output-chains", po::value<string>()->default_value(""),
+        "output file for the robbing chain statistics of TPTS")(
+        "lns", po::bool_switch()->default_value(false),
+        "improve the paths by large neighborhood search until the deadline")(
+        "lns-size", po::value<unsigned int>()->default_value(8),
+        "number of agents replanned together by the large neighborhood "
+        "search")(
+        "snapshot-ms", po::value<double>()->default_value(0),
+        "save the state before every TP or TPTS pass that takes longer than "
+        "this many ms, to replay it (0: off)")(
+        "snapshot-prefix", po::value<string>()->default_value("snapshot"),
+        "snapshots are saved to <prefix>-<n>.snap")(
+        "replay", po::value<string>()->default_value(""),
+        "run only the pass saved in this snapshot (of the same map and task "
+        "files) and print its time")(
+        "replay-repeat", po::value<int>()->default_value(1),
+        "number of times --replay runs the pass")(
         "verbose,v", po::bool_switch()->default_value(false),
         "print verbose output")("debug,d",
                                 po::bool_switch()->default_value(false),
@@ -54,24 +94,40 @@ int main(int argc, char **argv) {
 
     po::notify(vm);
 
-    if (algorithm == "TP") {
-      Simulation simu(vm["map"].as<string>(), vm["task"].as<string>(),
-                      vm["deadline"].as<unsigned int>(),
-                      vm["debug"].as<bool>());
-      simu.run_TOTP(vm["verbose"].as<bool>());
-      simu.SavePathUntilTimestep(vm["output-path"].as<string>(),
-                                 simu.end_timestep);
-      simu.SaveTaskUntilTimestep(vm["output-task"].as<string>(),
-                                 simu.end_timestep);
-    } else if (algorithm == "TPTS") {
-      Simulation simu(vm["map"].as<string>(), vm["task"].as<string>(),
-                      vm["deadline"].as<unsigned int>(),
-                      vm["debug"].as<bool>());
-      simu.run_TPTR(vm["verbose"].as<bool>());
-      simu.SavePathUntilTimestep(vm["output-path"].as<string>(),
+    Simulation simu(vm["map"].as<string>(), vm["task"].as<string>(),
+                    vm["deadline"].as<unsigned int>(), vm["debug"].as<bool>());
+    simu.UseSIPP(vm["sipp"].as<bool>());
+    simu.UsePathCache(vm["path-cache"].as<bool>(),
+                      vm["repair-window"].as<unsigned int>());
+    simu.LimitChains(vm["max-swap-depth"].as<unsigned int>(),
+                     vm["max-expansions"].as<unsigned long>());
+    if (!vm["replay"].as<string>().empty()) {
+      simu.Replay(vm["replay"].as<string>(), vm["replay-repeat"].as<int>(),
+                  vm["verbose"].as<bool>());
+      return 0;
+    }
+    simu.SnapshotSlowPasses(vm["snapshot-ms"].as<double>(),
+                            vm["snapshot-prefix"].as<string>());
+    for (size_t i = 0; i < algorithms.size(); i++) {
+      string suffix = algorithms.size() > 1 ? "." + algorithms[i] : "";
+      if (i > 0)
+        simu.Reset();
+      Time::time_point start = Time::now();
+      planners.Create(algorithms[i])->Run(simu, vm["verbose"].as<bool>());
+      if (vm["lns"].as<bool>())
+        simu.Improve(vm["lns-size"].as<unsigned int>(),
+                     vm["verbose"].as<bool>());
+      if (algorithms.size() > 1)
+        cout << algorithms[i] << ": "
+             << std::chrono::duration<double, std::milli>(Time::now() - start)
+                    .count()
+             << " ms, end timestep " << simu.end_timestep << endl;
+      simu.SavePathUntilTimestep(vm["output-path"].as<string>() + suffix,
                                  simu.end_timestep);
-      simu.SaveTaskUntilTimestep(vm["output-task"].as<string>(),
+      simu.SaveTaskUntilTimestep(vm["output-task"].as<string>() + suffix,
                                  simu.end_timestep);
+      if (!vm["output-chains"].as<string>().empty())
+        simu.SaveChains(vm["output-chains"].as<string>() + suffix);
     }
 
   } catch (exception &e) {
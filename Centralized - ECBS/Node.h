@@ -4,6 +4,7 @@
 #include <iostream>
 
 #include <boost/heap/fibonacci_heap.hpp>
+#include "bucketed_open_list.h"
 
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/trim_all.hpp>
@@ -35,15 +36,10 @@ public:
 	//         Hence, to achieve min-Head, we return true if lhs>rhs
 	///////////////////////////////////////////////////////////////////////////////
 
-	// the following is used to comapre nodes in the OPEN list
-	struct compare_node {
-		// returns true if n1 > n2 (note -- this gives us *min*-heap).
-		bool operator()(const Node* n1, const Node* n2) const {
-			if (n1->g_val + n1->h_val == n2->g_val + n2->h_val)
-				return n1->g_val <= n2->g_val;  // break ties towards larger g_vals
-			return n1->g_val + n1->h_val >= n2->g_val + n2->h_val;
-		}
-	};  // used by OPEN (heap) to compare nodes (top of the heap has min f-val, and then highest g-val)
+	// the following is used to bucket nodes in the OPEN list
+	struct open_key {
+		double operator()(const Node* n) const { return n->g_val + n->h_val; }
+	};  // used by OPEN (buckets) to group nodes by f-val
 
 		// the following is used to comapre nodes in the FOCAL list
 	struct secondary_compare_node {
@@ -59,7 +55,7 @@ public:
 	};  // used by FOCAL (heap) to compare nodes (top of the heap has min number-of-conflicts)
 
 		// define a typedefs for handles to the heaps (allow up to quickly update a node in the heap)
-	typedef boost::heap::fibonacci_heap< Node*, compare<compare_node> >::handle_type open_handle_t;
+	typedef open_bucket_handle_t open_handle_t;
 	typedef boost::heap::fibonacci_heap< Node*, compare<secondary_compare_node> >::handle_type focal_handle_t;
 
 	open_handle_t open_handle;
@@ -68,7 +64,7 @@ public:
 	Node(int loc, double g_val, double h_val, Node* parent, int timestep, int num_internal_conf = 0, bool in_openlist = false)
 		:loc(loc), g_val(g_val), h_val(h_val), parent(parent), timestep(timestep),
 		num_internal_conf(num_internal_conf), in_openlist(in_openlist) {}
-	Node::Node() : loc(0), g_val(0), h_val(0), parent(NULL), timestep(0), num_internal_conf(0), in_openlist(false) {}
+	Node() : loc(0), g_val(0), h_val(0), parent(NULL), timestep(0), num_internal_conf(0), in_openlist(false) {}
 	Node(const Node& other);
 	~Node();
 
@@ -1,16 +1,31 @@
 #include "Simulation.h"
 
 #include <ctime>
+#include <chrono>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 Simulation::Simulation(string map_name, string task_name)
+	:computation_time(0), num_computations(0), assign_search_k(3), assign_candidate_k(10), time_limit(500)
 {
 
 	LoadMap(map_name);
 	LoadTask(task_name);
-
+	assign_prices.resize(my_map.size(), 0);
+
+	int num_threads = 1;
+#ifdef _OPENMP
+	num_threads = omp_get_max_threads();
+#endif
+	for (int i = 0; i < num_threads; i++)
+		assign_res_tables.push_back(new ReservationTable());
 }
 Simulation::~Simulation()
 {
+	for (unsigned int i = 0; i < assign_res_tables.size(); i++)
+		delete assign_res_tables[i];
 }
 
 void Simulation::LoadMap(string fname)
@@ -122,7 +137,7 @@ void Simulation::LoadTask(string fname)
 }
 
 
-void Simulation::AssignTasks(vector<Agent*> &agents, const vector<vector<int> > &cons_paths)
+void Simulation::AssignTasks(vector<Agent*> &agents, const PathReservations &cons_paths)
 {
 	//hold goals of delivering tasks
 	vector<bool> hold(col*row, false);
@@ -150,22 +165,7 @@ void Simulation::AssignTasks(vector<Agent*> &agents, const vector<vector<int> >
 		for (unsigned int i = 0; i < agents.size(); i++)
 		{
 			//choose nearest endpoint ep for agent i
-			int ep = 0, dis = col*row;
-			for (unsigned int j = 0; j < endpoints.size(); j++)
-			{
-				if (hold[endpoints[j].loc] == false && endpoints[j].loc == agents[i]->loc)
-				{
-					ep = j;
-					dis = 0;
-					break;
-
-				}
-				else if (hold[endpoints[j].loc] == false && 0 < endpoints[j].h_val[agents[i]->loc] && endpoints[j].h_val[agents[i]->loc] < dis)
-				{
-					ep = j;
-					dis = endpoints[j].h_val[agents[i]->loc];
-				}
-			}
+			int ep = NearestFreeEndpoint(agents[i]->loc, hold);
 			hold[endpoints[ep].loc] = true;
 			starts.push_back(&endpoints[ep]);
 		}
@@ -173,71 +173,50 @@ void Simulation::AssignTasks(vector<Agent*> &agents, const vector<vector<int> >
 	
 
 	
-	//compute cost matrix
-	//cout << "Cost matrix:" << endl;
-	dlib::matrix<int> cost(starts.size(), starts.size());
-	for (unsigned int i = 0; i < starts.size(); i++)
+	//compute candidates (nearest tasks and endpoints of every agent)
+	vector<vector<pair<int, unsigned int> > > candidates(agents.size());
+	BuildCandidates(agents, starts, tasks.size(), cons_paths, candidates);
+	
+	//objects are the starts plus a private one per agent (no start) that keeps the auction feasible.
+	//Taking a task outweighs any path length, then shorter paths are preferred.
+	int64_t map_size = col*row;
+	int64_t task_bonus = map_size * this->agents.size();
+	auction.reset(agents.size(), starts.size() + agents.size());
+	for (unsigned int i = 0; i < agents.size(); i++)
 	{
-		if (i >= agents.size())
+		for (unsigned int c = 0; c < candidates[i].size(); c++)
 		{
-			for (unsigned int j = 0; j < starts.size(); j++)
-			{
-				cost(i, j) = 0;
-			}
-		}
-		else
-		{
-			for (unsigned int j = 0; j < tasks.size(); j++)
-			{
-				if (starts[j]->h_val[agents[i]->loc] == -1)
-				{
-					cost(i, j) = 0;
-					system("PAUSE");
-				}
-				else
-				{
-					bool* res_table = new bool[my_map.size() * maxtime]();  // initialized to false
-					SingleAgentECBS single(cons_paths, starts[j]->h_val, my_map, i, agents[i]->loc, starts[j]->loc, col, timestep, maxtime);
-					if (single.findPath(1, NULL, res_table, maxtime) == false)
-						cout << "NO SOLUTION EXISTS";
-					int path = single.path.size();
-					//cout << path << "	";
-					cost(i, j) = (2 * col*row - path)*agents.size()*starts.size();
-					delete[] res_table;
-				}
-			}
-			for (unsigned int j = tasks.size(); j < starts.size(); j++)
-			{
-				if (starts[j]->h_val[agents[i]->loc] == -1)
-				{
-					cost(i, j) = 0;
-					system("PAUSE");
-				}
-				else
-				{
-					bool* res_table = new bool[my_map.size() * maxtime]();  // initialized to false
-					SingleAgentECBS single(cons_paths, starts[j]->h_val, my_map, i, agents[i]->loc, starts[j]->loc, col, timestep, maxtime);
-					if (single.findPath(1, NULL, res_table, maxtime) == false)
-						cout << "NO SOLUTION EXISTS";
-					int path = single.path.size();
-					//cout << -path << "	";
-					cost(i, j) = col*row*agents.size()*starts.size() - path;
-					delete[] res_table;
-				}
-			}
-			//cout << endl;
+			unsigned int j = candidates[i][c].second;
+			auction.addEdge(i, j, map_size - candidates[i][c].first + (j < tasks.size() ? task_bonus : 0));
 		}
+		auction.addEdge(i, starts.size() + i, 0);
 	}
-	
-	// To find out the best assignment of people to jobs we just need to call this function.
-	vector<long> assignment = max_cost_assignment(cost);
+	//start from the prices of the last timestep, assignments barely change between timesteps
+	vector<double> prices(starts.size() + agents.size(), 0);
+	bool warm = false;
+	for (unsigned int j = 0; j < starts.size(); j++)
+	{
+		prices[j] = assign_prices[starts[j]->loc];
+		warm = warm || prices[j] != 0;
+	}
+	//bidding from scratch starts at the largest path benefit, warm prices only need small corrections
+	vector<int> assignment = auction.solve(prices, warm ? 1 : map_size);
+	for (unsigned int j = 0; j < starts.size(); j++)
+		assign_prices[starts[j]->loc] = prices[j];
 
 	
 	//assign
 	for (unsigned int i = 0; i < agents.size(); i++)
 	{
+		if (assignment[i] >= (int)starts.size()) //no candidate left, go to the nearest free endpoint
+		{
+			int ep = NearestFreeEndpoint(agents[i]->loc, hold);
+			hold[endpoints[ep].loc] = true;
+			assignment[i] = starts.size();
+			starts.push_back(&endpoints[ep]);
+		}
 		agents[i]->next_ep = starts[assignment[i]];
-		if (assignment[i] < tasks.size())
+		if (assignment[i] < (int)tasks.size())
 		{
 			//cout << "Agent " << agents[i]->id << " tasks Task " << tasks[assignment[i]]->start->loc << "-->" << tasks[assignment[i]]->goal->loc << endl;
 			//agents[i]->task = tasks[assignment[i]];
@@ -249,29 +228,111 @@ void Simulation::AssignTasks(vector<Agent*> &agents, const vector<vector<int> >
 		}
 	}
 }
-bool Simulation::PathFinding(vector<Agent*> &agents, const vector<vector<int> > &cons_paths)
+//Nearest non-holding endpoint of loc (loc itself if it is one)
+int Simulation::NearestFreeEndpoint(int loc, const vector<bool> &hold) const
+{
+	int ep = 0, dis = col*row;
+	for (unsigned int j = 0; j < endpoints.size(); j++)
+	{
+		if (hold[endpoints[j].loc] == false && endpoints[j].loc == loc)
+		{
+			return j;
+		}
+		else if (hold[endpoints[j].loc] == false && 0 < endpoints[j].h_val[loc] && endpoints[j].h_val[loc] < dis)
+		{
+			ep = j;
+			dis = endpoints[j].h_val[loc];
+		}
+	}
+	return ep;
+}
+//Candidates (path length, j) of agent i going to starts[j]: its assign_candidate_k nearest tasks and nearest other
+//starts, plus the endpoint added for it. Path lengths come from the precomputed distances (h_val); only the
+//assign_search_k nearest candidates of each agent are refined with a search that respects the delivering agents' paths.
+//Agents are independent and processed in parallel, each thread reusing its own search engine and reservation table.
+void Simulation::BuildCandidates(const vector<Agent*> &agents, const vector<Endpoint*> &starts, unsigned int num_tasks,
+	const PathReservations &cons_paths, vector<vector<pair<int, unsigned int> > > &candidates)
+{
+#pragma omp parallel
+	{
+		int thread = 0;
+#ifdef _OPENMP
+		thread = omp_get_thread_num();
+#endif
+		ReservationTable* res_table = assign_res_tables[thread];
+		res_table->resize(my_map.size(), maxtime);
+		SingleAgentECBS single(cons_paths, starts[0]->h_val, my_map, 0, agents[0]->loc, starts[0]->loc, col, timestep, maxtime);
+		vector<pair<int, unsigned int> > nearest_endpoints;
+
+#pragma omp for schedule(dynamic)
+		for (int i = 0; i < (int)agents.size(); i++)
+		{
+			vector<pair<int, unsigned int> > &nearest = candidates[i];
+			nearest.clear();
+			nearest_endpoints.clear();
+			unsigned int own_endpoint = num_tasks + i; //endpoint added for agent i (if any)
+			for (unsigned int j = 0; j < starts.size(); j++)
+			{
+				if (starts[j]->h_val[agents[i]->loc] == -1 || j == own_endpoint)
+					continue; //unreachable
+				int path = starts[j]->h_val[agents[i]->loc] + 1; //a path includes its start location
+				if (j < num_tasks)
+					nearest.push_back(make_pair(path, j));
+				else
+					nearest_endpoints.push_back(make_pair(path, j));
+			}
+			if (nearest.size() > assign_candidate_k)
+			{
+				nth_element(nearest.begin(), nearest.begin() + assign_candidate_k, nearest.end());
+				nearest.resize(assign_candidate_k);
+			}
+			if (nearest_endpoints.size() > assign_candidate_k)
+			{
+				nth_element(nearest_endpoints.begin(), nearest_endpoints.begin() + assign_candidate_k, nearest_endpoints.end());
+				nearest_endpoints.resize(assign_candidate_k);
+			}
+			nearest.insert(nearest.end(), nearest_endpoints.begin(), nearest_endpoints.end());
+			if (own_endpoint < starts.size() && starts[own_endpoint]->h_val[agents[i]->loc] != -1)
+				nearest.push_back(make_pair(starts[own_endpoint]->h_val[agents[i]->loc] + 1, own_endpoint));
+
+			unsigned int k = min((unsigned int)nearest.size(), assign_search_k);
+			partial_sort(nearest.begin(), nearest.begin() + k, nearest.end());
+			for (unsigned int c = 0; c < k; c++)
+			{
+				unsigned int j = nearest[c].second;
+				single.reset(i, agents[i]->loc, starts[j]->loc, starts[j]->h_val);
+				if (single.findPath(1, NULL, res_table->data(), maxtime))
+					nearest[c].first = single.path.size();
+			}
+		}
+	}
+}
+//ECBS for agents; if it fails (e.g., runs out of time), its best partial solution is repaired by prioritized planning
+bool Simulation::PathFinding(vector<Agent*> &agents, const PathReservations &cons_paths)
 {
-	ECBSSearch ecbs(my_map, agents, cons_paths, timestep, col, focal_w);
-	if (ecbs.runECBSSearch())
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	ECBSSearch ecbs(my_map, agents, cons_paths, timestep, col, focal_w, time_limit);
+	if (ecbs.runECBSSearch() || RepairPaths(agents, cons_paths, ecbs, start))
 	{
 		//update
 		for (unsigned int i = 0; i < agents.size(); i++)
 		{
 			//update searching path
-			for (unsigned int j = 0; j < ecbs.paths[i].size(); j++)
+			const vector<int> &path = *ecbs.paths[i];
+			for (unsigned int j = 0; j < path.size(); j++)
 			{
-				agents[i]->path[timestep + j] = ecbs.paths[i][j];
+				agents[i]->path[timestep + j] = path[j];
 			}
 			
 			//hold endpoint
-			for (unsigned int j = ecbs.paths[i].size() + timestep; j < maxtime; j++)
+			for (unsigned int j = path.size() + timestep; j < maxtime; j++)
 			{
 				agents[i]->path[j] = agents[i]->next_ep->loc;
 			}
 			//update task
 			if (agents[i]->delivering == true)
 			{
-				agents[i]->task->ag_arrive_goal= timestep + ecbs.paths[i].size() - 1;
+				agents[i]->task->ag_arrive_goal= timestep + path.size() - 1;
 			}
 			agents[i]->task = NULL;
 		}
@@ -280,7 +341,6 @@ bool Simulation::PathFinding(vector<Agent*> &agents, const vector<vector<int> >
 	else
 	{
 		cout << "CBS fails" << endl;
-		std::system("PAUSE");
 		//Recovery. Let robots move along its original paths.
 		for (unsigned int i = 0; i < agents.size(); i++)
 		{
@@ -301,15 +361,96 @@ bool Simulation::PathFinding(vector<Agent*> &agents, const vector<vector<int> >
 
 }
 
-void Simulation::run(double focal_w)
+//Prioritized planning seeded with ECBS's partial solution: agents are fixed one by one, each avoiding cons_paths and
+//the paths fixed before it. An agent keeps its partial-solution path unless it collides with those (it is replanned then).
+//Collision-free agents are fixed first; an agent left without a path is moved to the front and the planning restarts.
+//Returns false if the agent in front fails as well, or once time_limit has passed since start (the start of ECBS, so the
+//repair only gets what ECBS left of the budget).
+bool Simulation::RepairPaths(vector<Agent*> &agents, const PathReservations &cons_paths, ECBSSearch &ecbs,
+	std::chrono::steady_clock::time_point start)
+{
+	auto timed_out = [&]() {
+		if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() <= time_limit)
+			return false;
+		cout << "Repair timed out" << endl;
+		return true;
+	};
+	cout << "Repair " << ecbs.best_num_collisions << " colliding pairs of ECBS's partial solution" << endl;
+	vector<bool> colliding(agents.size(), false);
+	const vector<tuple<int, int, int, int, int> > &collisions = ecbs.collision_table.getCollisions();
+	for (unsigned int c = 0; c < collisions.size(); c++)
+	{
+		colliding[get<0>(collisions[c])] = true;
+		colliding[get<1>(collisions[c])] = true;
+	}
+
+	vector<int> full_path(maxtime); //path over the whole simulation (as recorded by reservations)
+	vector<unsigned int> priority;
+	for (int pass = 0; pass < 2; pass++)
+		for (unsigned int i = 0; i < agents.size(); i++)
+			if (colliding[i] == (pass == 1))
+				priority.push_back(i);
+	for (unsigned int attempt = 0; attempt < agents.size(); attempt++)
+	{
+		if (timed_out())
+			return false;
+		vector<path_ptr_t> paths = ecbs.paths;
+		PathReservations reservations(cons_paths);
+		bool solved = true;
+		unsigned int p;
+		for (p = 0; p < priority.size(); p++)
+		{
+			if (timed_out())
+				return false;
+			unsigned int i = priority[p];
+			bool replan = colliding[i] || !paths[i] || paths[i]->empty(); //no path in the partial solution
+			if (!replan)
+			{
+				const vector<int> &old_path = *paths[i];
+				for (unsigned int t = 1; t < old_path.size() && !replan; t++)
+					replan = reservations.isOccupied(old_path[t], timestep + t) ||
+						reservations.isMoveBlocked(old_path[t - 1], old_path[t], timestep + t);
+				if (!replan && reservations.getLastOccupiedTime(old_path.back()) >= (int)(timestep + old_path.size()))
+					replan = true; //cannot hold its goal
+			}
+			if (replan)
+			{
+				SingleAgentECBS single(reservations, agents[i]->next_ep->h_val, my_map, agents[i]->id, agents[i]->loc,
+					agents[i]->next_ep->loc, col, timestep, maxtime);
+				solved = single.findPath(1, NULL, NULL, 0);
+				if (!solved)
+					break;
+				paths[i] = make_shared<const vector<int> >(single.path);
+			}
+			const vector<int> &path = *paths[i];
+			for (unsigned int t = 0; t < maxtime; t++)
+				full_path[t] = t < timestep ? path[0] : (t - timestep < path.size() ? path[t - timestep] : path.back());
+			reservations.addPath(full_path);
+		}
+		if (solved)
+		{
+			ecbs.paths = paths;
+			return true;
+		}
+		if (p == 0)
+			return false;
+		unsigned int failed = priority[p];
+		priority.erase(priority.begin() + p);
+		priority.insert(priority.begin(), failed);
+	}
+	return false;
+}
+
+void Simulation::run(double focal_w, double time_limit)
 {
 	this->focal_w = focal_w;
+	this->time_limit = time_limit;
 	for (timestep = 0; timestep <= t_task || !tasks_assign.empty(); timestep++)
 	{
 		cout << endl << "Timestep " << timestep << endl;
 		vector<Agent*> ag_pathfinding;
 		vector<Agent*> ag_assign;
-		vector<vector<int> > cons_paths;
+		PathReservations cons_paths(my_map.size(), timestep); //paths of package agents (planned ones are avoided)
 		// delete FINISH tasks 	and update its agent's state	
 		for (list<Task*>::iterator it = tasks_deliver.begin(); it != tasks_deliver.end();)
 		{
@@ -345,7 +486,7 @@ void Simulation::run(double focal_w)
 			if (agents[i].delivering == false)
 				ag_loc[agents[i].loc] = i; // record non_package agents current loc
 			else
-				cons_paths.push_back(agents[i].path); //record package agents' paths
+				cons_paths.addPath(agents[i].path); //record package agents' paths
 		}
 		for (list<Task*>::iterator it = tasks_assign.begin(); it != tasks_assign.end();)
 		{
@@ -378,14 +519,15 @@ void Simulation::run(double focal_w)
 		}
 
 		num_computations++;
-		clock_t start = std::clock();
+		//wall-clock time, since candidates and ECBS children are computed in parallel
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
 		if (!ag_pathfinding.empty()) //path finding
 		{
 			PathFinding(ag_pathfinding, cons_paths);
 			for (int i = 0; i < ag_pathfinding.size(); i++)
 			{
-				cons_paths.push_back(ag_pathfinding[i]->path);
+				cons_paths.addPath(ag_pathfinding[i]->path);
 			}
 		}
 		ag_pathfinding.clear();
@@ -421,12 +563,9 @@ void Simulation::run(double focal_w)
 			PathFinding(ag_pathfinding, cons_paths);
 		}
 		
-		computation_time += (std::clock() - start);
+		computation_time += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
 
-		if (!TestConstraints()) //test correctness
-		{
-			std::system("PAUSE");
-		}
+		TestConstraints(); //test correctness (prints the first collision found)
 		
 	}
 }
@@ -488,8 +627,9 @@ void Simulation::SaveThroughput(const string &fname)
 	std::ofstream fout(fname + ".throughput");
 	if (!fout) return;
 	//fout << mPanel->agents.size() << std::endl;
-	vector<int> thpts(2500, 0);
-	vector<int> inpts(2500, 0);
+	//every count spreads over the 100 timesteps from its own
+	vector<int> thpts(maxtime + 100, 0);
+	vector<int> inpts(maxtime + 100, 0);
 
 	unsigned int WaitingTime = 0;
 	unsigned int LastFinish = 0;
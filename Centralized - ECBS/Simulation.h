@@ -9,17 +9,20 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <climits>
+#include <chrono>
 
 using namespace std;
 
 
 #include<boost/tokenizer.hpp>
-#include <dlib/optimization/max_cost_assignment.h>
 
 #include "Endpoint.h"
 #include "Agent.h"
 
 #include "ecbs_search.h"
+#include "reservation_table.h"
+#include "path_reservations.h"
+#include "auction_assignment.h"
 
 #include <iostream>
 #include <cstdlib>
@@ -33,8 +36,8 @@ public:
 	~Simulation();
 	
 
-	//run
-	void run( double focal_w);
+	//run (time_limit is the wall-clock budget in seconds of every ECBS call, including the repair of its partial solution)
+	void run( double focal_w, double time_limit = 500);
 	
 	//save
 	void ShowTask();
@@ -43,16 +46,23 @@ public:
 	void SaveThroughput(const string &fname);
 	void minCost();
 
-	double computation_time;
+	double computation_time; //wall-clock time of the planning in microseconds (the clock() ticks cobra reports)
 	int num_computations;
+	unsigned int assign_search_k; //number of nearest endpoints per agent whose cost is refined by a constrained search
+	unsigned int assign_candidate_k; //number of nearest tasks (and free endpoints) per agent the assignment considers
 
 private:
 	// initialize
 	void LoadMap(string fname);
 	void LoadTask(string fname);
 
-	void AssignTasks(vector<Agent*> &agents, const vector<vector<int> > &cons_paths);
-	bool PathFinding(vector<Agent*> &agents, const vector<vector<int> > &cons_paths);
+	void AssignTasks(vector<Agent*> &agents, const PathReservations &cons_paths);
+	void BuildCandidates(const vector<Agent*> &agents, const vector<Endpoint*> &starts, unsigned int num_tasks,
+		const PathReservations &cons_paths, vector<vector<pair<int, unsigned int> > > &candidates);
+	int NearestFreeEndpoint(int loc, const vector<bool> &hold) const;
+	bool PathFinding(vector<Agent*> &agents, const PathReservations &cons_paths);
+	bool RepairPaths(vector<Agent*> &agents, const PathReservations &cons_paths, ECBSSearch &ecbs,
+		std::chrono::steady_clock::time_point start);
 	bool TestConstraints();
 	
 private:
@@ -60,6 +70,7 @@ private:
 	vector<bool> my_map;
 	vector<bool> DeliverGoal; //goals of DELIVER tasks
 	double focal_w;
+	double time_limit;
 	//task
 	vector<list<Task>> tasks_total;
 	list<Task*> tasks_assign;
@@ -77,5 +88,9 @@ private:
 	int t_task;//timestep of last task
 
 	vector<int> endpoint_hashtable;//loc->endpointID
+
+	vector<ReservationTable*> assign_res_tables; //one per thread, reused by every search of the assignment stage
+	AuctionAssignment auction;
+	vector<double> assign_prices; //loc->price of the endpoint in the last assignment (next assignment starts from it)
 };
 
@@ -0,0 +1,150 @@
+#include "auction_assignment.h"
+#include <cmath>
+
+
+void AuctionAssignment::reset(int num_persons, int num_objects) {
+  this->num_persons = num_persons;
+  this->num_objects = num_objects;
+  person_edges.resize(num_persons);
+  object_edges.resize(num_objects);
+  for (int i = 0; i < num_persons; i++)
+    person_edges[i].clear();
+  for (int j = 0; j < num_objects; j++)
+    object_edges[j].clear();
+}
+
+
+void AuctionAssignment::addEdge(int person, int object, int64_t benefit) {
+  int64_t scaled = benefit * (num_persons + 1);
+  Edge to_object = {object, scaled};
+  Edge to_person = {person, scaled};
+  person_edges[person].push_back(to_object);
+  object_edges[object].push_back(to_person);
+}
+
+
+inline void AuctionAssignment::assign(int person, int object, int64_t benefit) {
+  int previous_person = object_person[object];
+  if (previous_person != -1)
+    person_object[previous_person] = -1;
+  int previous_object = person_object[person];
+  if (previous_object != -1)
+    object_person[previous_object] = -1;
+  person_object[person] = object;
+  object_person[object] = person;
+  person_benefit[person] = benefit;
+}
+
+
+// every person bids for its best object, raising its price by the margin over the second best (plus eps)
+void AuctionAssignment::forwardAuction(int64_t eps) {
+  person_object.assign(num_persons, -1);
+  object_person.assign(num_objects, -1);
+  person_benefit.assign(num_persons, 0);
+  queue.clear();
+  for (int i = num_persons - 1; i >= 0; i--)
+    queue.push_back(i);
+
+  while (!queue.empty()) {
+    int i = queue.back();
+    queue.pop_back();
+    int best_object = -1;
+    int64_t best_benefit = 0;
+    int64_t best_value = INT64_MIN, second_value = INT64_MIN;
+    for (size_t e = 0; e < person_edges[i].size(); e++) {
+      int64_t value = person_edges[i][e].benefit - price[person_edges[i][e].node];
+      if (value > best_value) {
+        second_value = best_value;
+        best_value = value;
+        best_object = person_edges[i][e].node;
+        best_benefit = person_edges[i][e].benefit;
+      } else if (value > second_value) {
+        second_value = value;
+      }
+    }
+    if (best_object == -1)
+      continue;  // no edge, stays unassigned
+    if (second_value == INT64_MIN)
+      second_value = best_value;  // single edge: nobody to outbid
+    price[best_object] += best_value - second_value + eps;
+    int outbid = object_person[best_object];
+    assign(i, best_object, best_benefit);
+    if (outbid != -1)
+      queue.push_back(outbid);
+  }
+}
+
+
+/* Objects left unassigned must not be more expensive than the assigned ones (lambda) for the assignment to be
+   optimal; each of them either drops to lambda or takes the person that profits the most from it.
+*/
+void AuctionAssignment::reverseAuction(int64_t eps) {
+  int64_t lambda = INT64_MAX;
+  for (int j = 0; j < num_objects; j++)
+    if (object_person[j] != -1 && price[j] < lambda)
+      lambda = price[j];
+  if (lambda == INT64_MAX)
+    return;
+  queue.clear();
+  for (int j = 0; j < num_objects; j++)
+    if (object_person[j] == -1 && price[j] > lambda)
+      queue.push_back(j);
+
+  while (!queue.empty()) {
+    int j = queue.back();
+    queue.pop_back();
+    if (object_person[j] != -1 || price[j] <= lambda)
+      continue;
+    int best_person = -1;
+    int64_t best_benefit = 0;
+    int64_t best_value = INT64_MIN, second_value = INT64_MIN;
+    for (size_t e = 0; e < object_edges[j].size(); e++) {
+      int i = object_edges[j][e].node;
+      if (person_object[i] == -1)
+        continue;
+      int64_t profit = person_benefit[i] - price[person_object[i]];
+      int64_t value = object_edges[j][e].benefit - profit;
+      if (value > best_value) {
+        second_value = best_value;
+        best_value = value;
+        best_person = i;
+        best_benefit = object_edges[j][e].benefit;
+      } else if (value > second_value) {
+        second_value = value;
+      }
+    }
+    if (best_person == -1 || best_value - eps <= lambda) {
+      price[j] = lambda;
+      continue;
+    }
+    price[j] = (second_value == INT64_MIN || second_value - eps < lambda) ? lambda : second_value - eps;
+    int released = person_object[best_person];
+    assign(best_person, j, best_benefit);
+    if (price[released] > lambda)
+      queue.push_back(released);
+  }
+}
+
+
+const vector<int>& AuctionAssignment::solve(vector<double>& prices, double start_eps) {
+  int64_t scale = num_persons + 1;
+  price.resize(num_objects);
+  for (int j = 0; j < num_objects; j++)
+    price[j] = llround(prices[j] * scale);
+
+  // with benefits scaled by num_persons+1, eps=1 leaves the total benefit within num_persons of the optimum
+  int64_t eps = start_eps * scale;
+  if (eps < 1)
+    eps = 1;
+  while (true) {
+    forwardAuction(eps);
+    reverseAuction(eps);
+    if (eps == 1)
+      break;
+    eps = eps / 4 > 1 ? eps / 4 : 1;
+  }
+
+  for (int j = 0; j < num_objects; j++)
+    prices[j] = (double)price[j] / scale;
+  return person_object;
+}
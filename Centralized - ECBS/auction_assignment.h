@@ -0,0 +1,53 @@
+// Auction algorithm for sparse (asymmetric) assignment problems, used to assign tasks to agents
+#ifndef AUCTIONASSIGNMENT_H
+#define AUCTIONASSIGNMENT_H
+
+#include <stdint.h>
+#include <vector>
+
+using std::vector;
+
+/* Maximizes the total benefit of assigning persons to distinct objects, where a person can only take the objects
+   it has an edge to (num_persons <= num_objects, and every person must be matchable -- e.g., give each person a
+   private object of benefit 0).
+   Forward auction with epsilon-scaling, followed by a reverse auction that lowers the prices of the objects left
+   unassigned (Bertsekas & Castanon, 1992). Benefits are scaled by num_persons+1 so the final assignment is optimal.
+   Prices are kept by the caller: solving again from the prices of a similar problem (e.g., the previous timestep)
+   skips most of the bidding.
+*/
+class AuctionAssignment {
+ public:
+  AuctionAssignment() : num_persons(0), num_objects(0) {}
+
+  void reset(int num_persons, int num_objects);
+  void addEdge(int person, int object, int64_t benefit);
+
+  /* Returns the object of every person. prices (one per object, in units of benefit) are the starting prices and
+     are replaced by the final ones. start_eps is the first bidding increment (in units of benefit): large when
+     prices are unknown, about 1 when they come from a similar problem.
+  */
+  const vector<int>& solve(vector<double>& prices, double start_eps);
+
+ private:
+  struct Edge {
+    int node;  // object (in person_edges) or person (in object_edges)
+    int64_t benefit;  // scaled by num_persons+1
+  };
+
+  void forwardAuction(int64_t eps);
+  void reverseAuction(int64_t eps);
+  void assign(int person, int object, int64_t benefit);
+
+  int num_persons;
+  int num_objects;
+  vector< vector<Edge> > person_edges;
+  vector< vector<Edge> > object_edges;
+
+  vector<int64_t> price;  // scaled
+  vector<int> person_object;  // -1 if unassigned
+  vector<int> object_person;  // -1 if unassigned
+  vector<int64_t> person_benefit;  // scaled benefit of the person's object
+  vector<int> queue;
+};
+
+#endif
@@ -0,0 +1,67 @@
+// OPEN list bucketed by f-value (used by both the low-level and the high-level focal searches)
+#ifndef BUCKETEDOPENLIST_H
+#define BUCKETEDOPENLIST_H
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+// where a node is stored in a BucketedOpenList (kept by the node itself as open_handle)
+struct open_bucket_handle_t {
+  double f_val;  // key of the bucket (the f-val when the node was pushed)
+  size_t index;  // position inside the bucket
+};
+
+/* Nodes with the same f-val (as returned by FVal) share a bucket and buckets are ordered by f-val.
+   Raising the focal bound from old to new only visits the buckets in (old,new], instead of all of OPEN.
+   Note -- a node's f-val must not change while it is in the list (erase it, update it, then push it again).
+*/
+template <class NodeT, class FVal>
+class BucketedOpenList {
+ public:
+  typedef std::map< double, std::vector<NodeT*> > buckets_t;
+
+  BucketedOpenList() : num_nodes(0) {}
+
+  void push(NodeT* n) {
+    std::vector<NodeT*>& bucket = buckets[FVal()(n)];
+    n->open_handle.f_val = FVal()(n);
+    n->open_handle.index = bucket.size();
+    bucket.push_back(n);
+    num_nodes++;
+  }
+
+  void erase(NodeT* n) {
+    typename buckets_t::iterator it = buckets.find(n->open_handle.f_val);
+    std::vector<NodeT*>& bucket = it->second;
+    size_t i = n->open_handle.index;
+    bucket[i] = bucket.back();
+    bucket[i]->open_handle.index = i;
+    bucket.pop_back();
+    if (bucket.empty())
+      buckets.erase(it);
+    num_nodes--;
+  }
+
+  // returns a node with the minimal f-val
+  NodeT* top() const { return buckets.begin()->second.back(); }
+
+  // calls visit(n) for every node with old_bound < f-val <= new_bound
+  template <class Visitor>
+  void visitRange(double old_bound, double new_bound, Visitor visit) const {
+    for (typename buckets_t::const_iterator it = buckets.upper_bound(old_bound);
+         it != buckets.end() && it->first <= new_bound; ++it)
+      for (size_t i = 0; i < it->second.size(); i++)
+        visit(it->second[i]);
+  }
+
+  size_t size() const { return num_nodes; }
+  bool empty() const { return num_nodes == 0; }
+  void clear() { buckets.clear(); num_nodes = 0; }
+
+ private:
+  buckets_t buckets;
+  size_t num_nodes;
+};
+
+#endif
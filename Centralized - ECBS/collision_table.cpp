@@ -0,0 +1,151 @@
+#include "collision_table.h"
+#include <algorithm>
+#include <climits>
+
+
+CollisionTable::CollisionTable(int map_size)
+  : map_size(map_size), paths(NULL), max_path_length(0),
+    earliest_collision(-1, -1, -1, -1, INT_MAX), num_colliding_pairs(0) {
+}
+
+
+inline int CollisionTable::firstEntry(int loc, int timestep) const {
+  unordered_map<uint64_t, int>::const_iterator it = cells.find(key(loc, timestep));
+  return it == cells.end() ? -1 : it->second;
+}
+
+
+void CollisionTable::addCollision(int agent1_id, int agent2_id, int location1, int location2, int timestep) {
+  collisions.push_back(std::make_tuple(agent1_id, agent2_id, location1, location2, timestep));
+  // earliest by (timestep, agent1_id, agent2_id, vertex before edge) -- same as the pairwise scan used to pick
+  int e_agent1_id, e_agent2_id, e_location1, e_location2, e_timestep;
+  std::tie(e_agent1_id, e_agent2_id, e_location1, e_location2, e_timestep) = earliest_collision;
+  if (timestep < e_timestep ||
+      (timestep == e_timestep &&
+       (agent1_id < e_agent1_id ||
+        (agent1_id == e_agent1_id &&
+         (agent2_id < e_agent2_id || (agent2_id == e_agent2_id && location2 == -1 && e_location2 != -1))))))
+    earliest_collision = collisions.back();
+}
+
+
+void CollisionTable::build(const vector<path_ptr_t>& paths) {
+  this->paths = &paths;
+  int num_of_agents = paths.size();
+  cells.clear();
+  entries.clear();
+  last_locations.clear();
+  collisions.clear();
+  earliest_collision = std::make_tuple(-1, -1, -1, -1, INT_MAX);
+  num_colliding_pairs = 0;
+
+  // hash the moving part of every path (its last location is kept apart, see last_locations)
+  max_path_length = 0;
+  size_t num_entries = 0;
+  for (int ag = 0; ag < num_of_agents; ag++) {
+    if (!paths[ag])
+      continue;
+    num_entries += paths[ag]->size();
+    if ((int)paths[ag]->size() > max_path_length)
+      max_path_length = paths[ag]->size();
+  }
+  entries.reserve(num_entries);
+  cells.reserve(num_entries);
+  for (int ag = 0; ag < num_of_agents; ag++) {
+    if (!paths[ag] || paths[ag]->empty())
+      continue;
+    const vector<int>& p = *paths[ag];
+    for (size_t t = 0; t < p.size(); t++) {
+      Entry e = { ag, -1 };
+      std::pair<unordered_map<uint64_t, int>::iterator, bool> ins = cells.insert(std::make_pair(key(p[t], t), (int)entries.size()));
+      if (!ins.second) {
+        e.next = ins.first->second;
+        ins.first->second = entries.size();
+      }
+      entries.push_back(e);
+    }
+    last_locations[p.back()].push_back(ag);
+  }
+
+  // each collision is reported once, by the agent still moving at that timestep (the lower id if both are)
+  for (int a1 = 0; a1 < num_of_agents; a1++) {
+    if (!paths[a1])
+      continue;
+    const vector<int>& p1 = *paths[a1];
+    for (int t = 0; t < (int)p1.size(); t++) {
+      int loc = p1[t];
+      // vertex collisions with agents moving at t
+      for (int i = firstEntry(loc, t); i != -1; i = entries[i].next) {
+        int a2 = entries[i].agent_id;
+        if (a2 > a1)
+          addCollision(a1, a2, loc, -1, t);
+      }
+      // vertex collisions with agents already waiting at their last location
+      unordered_map<int, vector<int> >::const_iterator it = last_locations.find(loc);
+      if (it != last_locations.end()) {
+        for (size_t j = 0; j < it->second.size(); j++) {
+          int a2 = it->second[j];
+          if (a2 != a1 && (int)paths[a2]->size() <= t)
+            addCollision(std::min(a1, a2), std::max(a1, a2), loc, -1, t);
+        }
+      }
+      // edge collisions (both agents have to move, hence both are hashed at t and t+1)
+      if (t + 1 < (int)p1.size() && p1[t + 1] != loc) {
+        for (int i = firstEntry(p1[t + 1], t); i != -1; i = entries[i].next) {
+          int a2 = entries[i].agent_id;
+          if (a2 > a1 && t + 1 < (int)paths[a2]->size() && (*paths[a2])[t + 1] == loc)
+            addCollision(a1, a2, loc, p1[t + 1], t);
+        }
+      }
+    }
+  }
+
+  // count distinct pairs
+  vector< std::pair<int, int> > pairs;
+  pairs.reserve(collisions.size());
+  for (size_t i = 0; i < collisions.size(); i++)
+    pairs.push_back(std::make_pair(std::get<0>(collisions[i]), std::get<1>(collisions[i])));
+  std::sort(pairs.begin(), pairs.end());
+  num_colliding_pairs = std::unique(pairs.begin(), pairs.end()) - pairs.begin();
+}
+
+
+int CollisionTable::countCollidingAgents(int agent_id, const vector<int>& path) const {
+  if (path.empty())
+    return 0;
+  vector<int> colliding;  // agents found so far (few, so a linear scan beats a set)
+  auto add = [&colliding](int a) {
+    if (std::find(colliding.begin(), colliding.end(), a) == colliding.end())
+      colliding.push_back(a);
+  };
+
+  int len = path.size();
+  for (int t = 0; t < len; t++) {
+    int loc = path[t];
+    for (int i = firstEntry(loc, t); i != -1; i = entries[i].next)
+      if (entries[i].agent_id != agent_id)
+        add(entries[i].agent_id);
+    unordered_map<int, vector<int> >::const_iterator it = last_locations.find(loc);
+    if (it != last_locations.end()) {
+      for (size_t j = 0; j < it->second.size(); j++) {
+        int a2 = it->second[j];
+        if (a2 != agent_id && (int)(*paths)[a2]->size() <= t)
+          add(a2);
+      }
+    }
+    if (t + 1 < len && path[t + 1] != loc) {
+      for (int i = firstEntry(path[t + 1], t); i != -1; i = entries[i].next) {
+        int a2 = entries[i].agent_id;
+        if (a2 != agent_id && t + 1 < (int)(*paths)[a2]->size() && (*(*paths)[a2])[t + 1] == loc)
+          add(a2);
+      }
+    }
+  }
+  // agent_id waits at its last location while others are still moving
+  int goal = path.back();
+  for (int t = len; t < max_path_length; t++)
+    for (int i = firstEntry(goal, t); i != -1; i = entries[i].next)
+      if (entries[i].agent_id != agent_id)
+        add(entries[i].agent_id);
+  return colliding.size();
+}
@@ -0,0 +1,66 @@
+// Spatial hash of agents' paths used for collision detection (High-level)
+#ifndef COLLISIONTABLE_H
+#define COLLISIONTABLE_H
+
+#include <stdint.h>
+#include <tuple>
+#include <vector>
+#include <unordered_map>
+#include "ecbs_node.h"
+
+using std::tuple;
+using std::vector;
+using std::unordered_map;
+
+class CollisionTable {
+ public:
+  explicit CollisionTable(int map_size);
+
+  /* Hashes every (location, timestep) visited by paths and records all vertex and edge collisions in O(A*T).
+     As in ECBSSearch, an agent remains at its last location once its path ends.
+     Note -- paths must outlive the table (it is read again by countCollidingAgents()). NULL paths are ignored.
+  */
+  void build(const vector<path_ptr_t>& paths);
+
+  /* All collisions found by build(). A collision is a tuple of <int agent1_id, agent2_id, int location1, int location2, int timestep>
+     (agent1_id < agent2_id ; location2=-1 for vertex collision).
+  */
+  const vector< tuple<int, int, int, int, int> >& getCollisions() const { return collisions; }
+
+  /* The earliest collision (ties broken towards lower agent ids, vertex before edge). timestep=INT_MAX if none.
+   */
+  const tuple<int, int, int, int, int>& getEarliestCollision() const { return earliest_collision; }
+
+  /* Number of pairs of agents colliding (h_3 in ECBS's paper) in the hashed paths.
+   */
+  int getNumOfCollidingAgents() const { return num_colliding_pairs; }
+
+  /* Number of agents colliding with agent_id if it followed path instead of its hashed path.
+     Used to re-check only the agent replanned by a high-level child (the other paths are those given to build()).
+  */
+  int countCollidingAgents(int agent_id, const vector<int>& path) const;
+
+ private:
+  struct Entry {
+    int agent_id;
+    int next;  // next entry in the same cell (-1 ends the list)
+  };
+
+  inline uint64_t key(int loc, int timestep) const { return (uint64_t)timestep * map_size + loc; }
+  inline int firstEntry(int loc, int timestep) const;
+  void addCollision(int agent1_id, int agent2_id, int location1, int location2, int timestep);
+
+  int map_size;
+  const vector<path_ptr_t>* paths;
+  int max_path_length;
+
+  unordered_map<uint64_t, int> cells;  // (timestep*map_size+loc) -> first entry
+  vector<Entry> entries;
+  unordered_map<int, vector<int> > last_locations;  // loc -> agents whose path ends there
+
+  vector< tuple<int, int, int, int, int> > collisions;
+  tuple<int, int, int, int, int> earliest_collision;
+  int num_colliding_pairs;
+};
+
+#endif
@@ -0,0 +1,18 @@
+#include "constraint_table.h"
+
+#include <algorithm>
+
+
+ConstraintTable::ConstraintTable(std::shared_ptr<const ConstraintTable> parent, int loc1, int loc2, int timestep)
+    : parent(parent), loc1(loc1), loc2(loc2), timestep(timestep), num(parent ? parent->num + 1 : 1) {
+}
+
+
+int ConstraintTable::getLatestTimestep(int loc) const {
+  int t = -1;
+  for (const ConstraintTable* c = this; c != NULL; c = c->parent.get()) {
+    if (c->loc1 == loc || c->loc2 == loc)
+      t = std::max(t, c->timestep);
+  }
+  return t;
+}
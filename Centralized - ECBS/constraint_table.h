@@ -0,0 +1,39 @@
+// Constraints imposed on one agent along a branch of the constraint tree (High-level)
+#ifndef CONSTRAINTTABLE_H
+#define CONSTRAINTTABLE_H
+
+#include <memory>
+
+/* A persistent list: every table holds one constraint and points to the table of its agent's latest ancestor,
+   so generating a child costs O(1) whatever the depth of its branch, and tables are shared by ECBSNodes (through
+   a shared_ptr) and never change once built. The low-level search loads the list into hash sets once per search
+   (SingleAgentECBS::loadConstraints) and looks constraints up there.
+*/
+class ConstraintTable {
+ public:
+  /* The constraints of parent (NULL for none) plus <loc1,loc2,timestep> (loc2=-1 for vertex constraint).
+     An edge constraint disallows the move from loc1 at timestep to loc2 at timestep+1.
+  */
+  ConstraintTable(std::shared_ptr<const ConstraintTable> parent, int loc1, int loc2, int timestep);
+
+  /* Calls visit(loc1, loc2, timestep) for every constraint of the list, the newest first.
+   */
+  template <typename Visit>
+  void visitAll(Visit visit) const {
+    for (const ConstraintTable* c = this; c != NULL; c = c->parent.get())
+      visit(c->loc1, c->loc2, c->timestep);
+  }
+
+  /* Returns the latest timestep of a constraint involving loc (-1 if none).
+   */
+  int getLatestTimestep(int loc) const;
+
+  size_t size() const { return num; }
+
+ private:
+  std::shared_ptr<const ConstraintTable> parent;
+  int loc1, loc2, timestep;
+  size_t num;  // number of constraints in the list
+};
+
+#endif
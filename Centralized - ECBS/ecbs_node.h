@@ -7,20 +7,27 @@
 #include <list>
 #include <climits>
 #include <tuple>
+#include <memory>
 #include <boost/heap/fibonacci_heap.hpp>
-#include "node.h"
+#include "Node.h"
+#include "bucketed_open_list.h"
+#include "constraint_table.h"
 
 using boost::heap::fibonacci_heap;
 using boost::heap::compare;
 
 using namespace std;
 
+// paths are immutable once found, so high-level nodes (and the current solution) share them instead of copying
+typedef std::shared_ptr<const vector<int> > path_ptr_t;
+
 class ECBSNode {
  public:
   int agent_id;
   tuple<int, int, int> constraint;  // <int loc1, int loc2, int timestep> NOTE--loc2=-1 for Vertex Constraint
+  std::shared_ptr<const ConstraintTable> constraint_table;  // all constraints on agent_id from this node up to the root
   ECBSNode* parent;
-  vector<int> path;
+  path_ptr_t path;
   double g_val;  // (total cost)
   double h_val;  // (number of collisions)
   int time_expanded;
@@ -29,12 +36,10 @@ class ECBSNode {
   double ll_min_f_val;  // saves this agent's low-level min-f-val (as reported by the search that found the path stored)
   double path_cost;  // saves this agent's low-level path-cost
 
-  // the following is used to comapre nodes in the OPEN list
-  struct compare_node {
-    bool operator()(const ECBSNode* n1, const ECBSNode* n2) const {
-      return n1->sum_min_f_vals >= n2->sum_min_f_vals;
-    }
-  };  // used by OPEN to compare nodes by sum_min_f_vals (top of the heap has min sum_min_f_vals)
+  // the following is used to bucket nodes in the OPEN list
+  struct open_key {
+    double operator()(const ECBSNode* n) const { return n->sum_min_f_vals; }
+  };  // used by OPEN to group nodes by sum_min_f_vals (first bucket has min sum_min_f_vals)
 
   // the following is used to comapre nodes in the FOCAL list
   struct secondary_compare_node {
@@ -45,7 +50,7 @@ class ECBSNode {
     }
   };  // used by FOCAL to compare nodes by h_val (top of the heap has min h-val)
 
-  typedef boost::heap::fibonacci_heap< ECBSNode* , compare<compare_node> >::handle_type open_handle_t;
+  typedef open_bucket_handle_t open_handle_t;
   typedef boost::heap::fibonacci_heap< ECBSNode* , compare<secondary_compare_node> >::handle_type focal_handle_t;
 
   open_handle_t open_handle;
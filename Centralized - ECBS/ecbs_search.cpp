@@ -6,6 +6,7 @@
 #include <vector>
 #include <tuple>
 #include <ctime>
+#include <chrono>
 #include <climits>
 
 #include <boost/property_tree/ptree.hpp>
@@ -16,9 +17,9 @@ namespace pt = boost::property_tree;
 void ECBSSearch::printPaths() {
   for (size_t i = 0; i < paths.size(); i++) {
 	  cout << "AGENT " << agents[i]->id << " Path: ";
-	for (unsigned int j = 0; j < paths[i].size(); j++) 
+	for (unsigned int j = 0; paths[i] && j < paths[i]->size(); j++) 
 	{
-		std::cout << paths[i][j] << " ";
+		std::cout << (*paths[i])[j] << " ";
     }
     cout << endl;
   }
@@ -84,7 +85,7 @@ inline void ECBSSearch::releaseClosedListNodes() {
 inline double ECBSSearch::compute_g_val() {
   double retVal = 0;
   for (int i = 0; i < num_of_agents; i++)
-    retVal += paths[i].size();
+    retVal += paths[i]->size();
   return retVal;
 }
 
@@ -99,21 +100,22 @@ inline double ECBSSearch::compute_hl_lower_bound() {
 
 
 // adding new nodes to FOCAL (those with min-f-val*f_weight between the old and new LB)
+// (only the OPEN buckets in that range are visited)
 void ECBSSearch::updateFocalList(double old_lower_bound, double new_lower_bound, double f_weight) {
-  for (ECBSNode* n : open_list) {
-    if ( n->sum_min_f_vals > old_lower_bound &&
-         n->sum_min_f_vals <= new_lower_bound )
-      n->focal_handle = focal_list.push(n);
-  }
+  open_list.visitRange(old_lower_bound, new_lower_bound, [this](ECBSNode* n) {
+    n->focal_handle = focal_list.push(n);
+  });
 }
 
 
 // takes the paths_found_initially and UPDATE all (constrained) paths found for agents from curr to start
 // also, do the same for ll_min_f_vals and paths_costs (since its already "on the way").
+// Note -- only the path pointers are copied (O(A)), paths themselves are shared with the nodes.
 inline void ECBSSearch::updatePaths(ECBSNode* curr, ECBSNode* root_node) {
   paths = paths_found_initially;
   ll_min_f_vals = ll_min_f_vals_found_initially;
   paths_costs = paths_costs_found_initially;
+  constraint_tables.assign(num_of_agents, std::shared_ptr<const ConstraintTable>());
   vector<bool> updated(num_of_agents, false);  // initialized for false
   /* used for backtracking -- only update paths[i] if it wasn't updated before (that is, by a younger node)
    * because younger nodes take into account ancesstors' nodes constraints. */
@@ -122,6 +124,7 @@ inline void ECBSSearch::updatePaths(ECBSNode* curr, ECBSNode* root_node) {
       paths[curr->agent_id] = curr->path;
       ll_min_f_vals[curr->agent_id] = curr->ll_min_f_val;
       paths_costs[curr->agent_id] = curr->path_cost;
+      constraint_tables[curr->agent_id] = curr->constraint_table;
       updated[curr->agent_id] = true;
     }
     curr = curr->parent;
@@ -145,70 +148,43 @@ void ECBSSearch::updatePathsForExpTime(int t_exp) {
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// find all constraints on this agent (recursing to the root) and compute (and store) a path satisfying them.
+// build the constraint table of this agent and compute (and store) a path satisfying it.
 // returns true only if such a path exists (otherwise false and path remain empty).
-inline bool ECBSSearch::updateECBSNode(ECBSNode* leaf_node, ECBSNode* root_node) {
-  // extract all constraints on leaf_node->agent_id
-  list < tuple<int, int, int> > constraints;  // each constraint is <L1,L2,T>
+// Note -- the leaf's parent must be the node last passed to updatePaths (its agents' constraint tables are reused).
+inline bool ECBSSearch::updateECBSNode(ECBSNode* leaf_node, ReservationTable& res_table) {
+  // the constraints on leaf_node->agent_id are those of its latest ancestor for the same agent plus its own
   int agent_id = leaf_node->agent_id;
-  //  cout << " update ECBS node for agent:" << agent_id << endl;
-  ECBSNode* curr = leaf_node;
-  //  cout << "  Find all constraints on him:" << endl;
-  while (curr != root_node) {
-    if (curr->agent_id == agent_id) {
-      constraints.push_front(curr->constraint);
-      //      cout << "   L1:" << get<0>(curr->constraint) << " ; L2:" << get<1>(curr->constraint) << " ; T:" << get<2>(curr->constraint) << endl;
-    }
-    curr = curr->parent;
-  }
-  // cout << "  OVERALL #CONS:" << constraints.size() << endl;
-
-  // calc constraints' max_timestep
-  int max_timestep = -1;
-  for (list< tuple<int, int, int> >::iterator it = constraints.begin(); it != constraints.end(); it++)
-    if ( get<2>(*it) > max_timestep )
-      max_timestep = get<2>(*it);
-  // cout << "  Latest constraint's timestep:" << max_timestep << endl;
-
-  // initialize a constraint vector of length max_timestep+1. Each entry is an empty list< pair<int,int> > (loc1,loc2)
-  //  cout << "  Creating a list of constraints (per timestep):" << endl;
-  vector < list< pair<int, int> > >* cons_vec = new vector < list< pair<int, int> > > ( max_timestep+1, list< pair<int, int> > () );
-  for (list< tuple<int, int, int> >::iterator it = constraints.begin(); it != constraints.end(); it++) {
-    //    cout << "   PUSHING a constraint for time:" << get<2>(*it) << " ; (constraint is [" << get<0>(*it) << "," << get<1>(*it) << "])" << endl;
-    cons_vec->at(get<2>(*it)).push_back(make_pair(get<0>(*it), get<1>(*it)));
-  }
+  ConstraintTable* cons = new ConstraintTable(constraint_tables[agent_id], get<0>(leaf_node->constraint),
+                                              get<1>(leaf_node->constraint), get<2>(leaf_node->constraint));
+  leaf_node->constraint_table.reset(cons);  // shared with descendants (read-only from now on)
 
   // build reservation table
   size_t max_plan_len = getPathsMaxLength();
-  bool* res_table = new bool[map_size * max_plan_len]();  // initialized to false
+  res_table.resize(map_size, max_plan_len);
   updateReservationTable(res_table, max_plan_len, agent_id);
 
-  //  printResTable(res_table, max_plan_len);
+  //  printResTable(res_table.data(), max_plan_len);
 
-  // find a path w.r.t cons_vec (and prioretize by res_table).
-  bool foundSol = search_engines[agent_id]->findPath(focal_w, cons_vec, res_table, max_plan_len);
-  LL_num_expanded += search_engines[agent_id]->num_expanded;
-  LL_num_generated += search_engines[agent_id]->num_generated;
+  // find a path w.r.t cons (and prioretize by res_table).
+  // Note -- LL_num_expanded/LL_num_generated are updated by the caller (children are generated concurrently)
+  bool foundSol = search_engines[agent_id]->findPath(focal_w, cons, res_table.data(), max_plan_len);
 
 #ifndef NDEBUG
   cout << "Run search for AG" << agent_id << " ; found solution? " << std::boolalpha << foundSol;
 #endif
   // update leaf's path to the one found and its low-level search's min f-val
   if (foundSol) {
-    leaf_node->path = search_engines[agent_id]->path;
+    leaf_node->path = std::make_shared<const vector<int> >(search_engines[agent_id]->path);
     leaf_node->ll_min_f_val = search_engines[agent_id]->min_f_val;
     leaf_node->path_cost = search_engines[agent_id]->path_cost;
 #ifndef NDEBUG
     /*cout << " ; path-cost=" << (leaf_node->path_cost) << " ; for which min-f-val=" << leaf_node->ll_min_f_val << " ; The path is:";
-    for (vector<int>::iterator it = leaf_node->path.begin(); it != leaf_node->path.end(); it++)
+    for (vector<int>::const_iterator it = leaf_node->path->begin(); it != leaf_node->path->end(); it++)
       cout << *it << " ";*/
 #endif
   }
   //  cout << endl;
 
-  // release memory allocated here and return
-  delete (cons_vec);
-  delete[] res_table;
   return foundSol;
 }
 ////////////////////////////////////////////////////////////////////////////////
@@ -220,10 +196,11 @@ inline bool ECBSSearch::updateECBSNode(ECBSNode* leaf_node, ECBSNode* root_node)
  */
 inline int ECBSSearch::getAgentLocation(int agent_id, size_t timestep) {
   // if last timestep > plan length, agent remains in its last location
-  if (timestep >= paths[agent_id].size())
-    return paths[agent_id][paths[agent_id].size()-1];
+  const vector<int>& path = *paths[agent_id];
+  if (timestep >= path.size())
+    return path[path.size()-1];
   // otherwise, return its location for that timestep
-  return paths[agent_id][timestep];
+  return path[timestep];
 }
 
 /*
@@ -231,7 +208,7 @@ inline int ECBSSearch::getAgentLocation(int agent_id, size_t timestep) {
  */
 inline bool ECBSSearch::switchedLocations(int agent1_id, int agent2_id, size_t timestep) {
   // if both agents at their goal, they are done moving (cannot switch places)
-  if ( timestep >= paths[agent1_id].size() && timestep >= paths[agent2_id].size() )
+  if ( timestep >= paths[agent1_id]->size() && timestep >= paths[agent2_id]->size() )
     return false;
   if ( getAgentLocation(agent1_id, timestep) == getAgentLocation(agent2_id, timestep+1) &&
        getAgentLocation(agent1_id, timestep+1) == getAgentLocation(agent2_id, timestep) )
@@ -243,36 +220,13 @@ inline bool ECBSSearch::switchedLocations(int agent1_id, int agent2_id, size_t t
   Emulate agents' paths and returns a vector of collisions
   Note - a collision is a tuple of <int agent1_id, agent2_id, int location1, int location2, int timestep>).
   Note - the tuple's location_2=-1 for vertex collision.
+  Note - collisions are found by hashing the paths (O(A*T)) rather than by comparing every pair of agents.
+         The table is kept so that children of the expanded node can be re-checked incrementally.
  */
 vector< tuple<int, int, int, int, int> >* ECBSSearch::extractCollisions() {
-  vector< tuple<int, int, int, int, int> >* cons_found = new vector< tuple<int, int, int, int, int> >();
-  earliest_conflict = make_tuple(-1, -1, -1, -1, INT_MAX);
-  for (int a1 = 0; a1 < num_of_agents; a1++) {
-    for (int a2 = a1+1; a2 < num_of_agents; a2++) {
-      size_t max_path_length = paths[a1].size() > paths[a2].size() ? paths[a1].size() : paths[a2].size();
-      for (size_t timestep = 0; timestep < max_path_length; timestep++) {
-        if ( getAgentLocation(a1, timestep) == getAgentLocation(a2, timestep) ) {
-          cons_found->push_back(make_tuple(a1,
-                                           a2,
-                                           getAgentLocation(a1, timestep),
-                                           -1,  // vertex collision (hence loc2=-1)
-                                           timestep) );
-          if ((int)timestep < std::get<4>(earliest_conflict))
-            earliest_conflict = make_tuple(a1, a2, getAgentLocation(a1, timestep), -1, timestep);
-        }
-        if ( switchedLocations(a1, a2, timestep) ) {
-          cons_found->push_back(make_tuple(a1,
-                                           a2,
-                                           getAgentLocation(a1, timestep),
-                                           getAgentLocation(a2, timestep),
-                                           timestep) );
-          if ((int)timestep < std::get<4>(earliest_conflict))
-            earliest_conflict = make_tuple(a1, a2, getAgentLocation(a1, timestep), getAgentLocation(a2, timestep), timestep);
-        }
-      }
-    }
-  }
-  return cons_found;
+  collision_table.build(paths);
+  earliest_conflict = collision_table.getEarliestCollision();
+  return new vector< tuple<int, int, int, int, int> >(collision_table.getCollisions());
 }
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -280,20 +234,20 @@ vector< tuple<int, int, int, int, int> >* ECBSSearch::extractCollisions() {
 size_t ECBSSearch::getPathsMaxLength() {
   size_t retVal = 0;
   for (int ag = 0; ag < num_of_agents; ag++)
-    if ( !paths[ag].empty() && paths[ag].size() > retVal )
-      retVal = paths[ag].size();
+    if ( paths[ag] && paths[ag]->size() > retVal )
+      retVal = paths[ag]->size();
   return retVal;
 }
 
 // Generates a boolean reservation table for paths (cube of map_size*max_timestep).
 // This is used by the low-level ECBS to count possible collisions efficiently
 // Note -- we do not include the agent for which we are about to plan for
-void ECBSSearch::updateReservationTable(bool* res_table, size_t max_path_len, int exclude_agent) {
+void ECBSSearch::updateReservationTable(ReservationTable& res_table, size_t max_path_len, int exclude_agent) {
   for (int ag = 0; ag < num_of_agents; ag++) {
-    if (ag != exclude_agent && !paths[ag].empty()) {
+    if (ag != exclude_agent && paths[ag] && !paths[ag]->empty()) {
       for (size_t timestep = 0; timestep < max_path_len; timestep++) {
         int id = getAgentLocation(ag, timestep);
-        res_table[id + timestep*map_size] = true;
+        res_table.reserve(id, timestep);
       }
     }
   }
@@ -301,37 +255,28 @@ void ECBSSearch::updateReservationTable(bool* res_table, size_t max_path_len, in
 
 // Compute the number of pairs of agents colliding (h_3 in ECBS's paper)
 int ECBSSearch::computeNumOfCollidingAgents() {
-  //  cout << "   *-*-* Computed number of colliding agents: " << endl;
-  int retVal = 0;
-  for (int a1 = 0; a1 < num_of_agents; a1++) {
-    for (int a2 = a1+1; a2 < num_of_agents; a2++) {
-      size_t max_path_length = paths[a1].size() > paths[a2].size() ? paths[a1].size() : paths[a2].size();
-      for (size_t timestep = 0; timestep < max_path_length; timestep++) {
-        //        cout << "   A1:" << getAgentLocation(a1, timestep) << ", A2:" <<  getAgentLocation(a2, timestep) << ", T:" << timestep;
-        if ( getAgentLocation(a1, timestep) == getAgentLocation(a2, timestep) ||
-             switchedLocations(a1, a2, timestep) ) {
-          retVal++;
-          // break to the outer (a1) loop
-          timestep = max_path_length;
-          a2 = num_of_agents;
-          //          cout << " !BOOM! ";
-        }
-      }
-    }
-  }
-  //  cout << "   *-*-* Computed number of colliding agents returns: " << retVal << endl;
-  return retVal;
+  collision_table.build(paths);
+  return collision_table.getNumOfCollidingAgents();
+}
+
+// Same as above for paths with agent_id's path replaced by new_path.
+// Only agent_id is re-checked against the table built by the last extractCollisions() (paths must not have changed since).
+int ECBSSearch::computeNumOfCollidingAgents(int agent_id, const vector<int>& new_path) {
+  return collision_table.getNumOfCollidingAgents()
+      - collision_table.countCollidingAgents(agent_id, *paths[agent_id])
+      + collision_table.countCollidingAgents(agent_id, new_path);
 }
 
 
 //CBSSearch::CBSSearch(const vector<bool> &my_map, vector<Agent*> &agents, const vector<vector<int> > &cons_paths, int curr_time, int col)
 //	:cons_paths(cons_paths), num_expanded(0), curr_time(curr_time), agents(agents)
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
-ECBSSearch::ECBSSearch(const vector<bool> &my_map, vector<Agent*> &agents, const vector<vector<int> > &cons_paths, 
-						int curr_time, int col, double f_w)
-	:cons_paths(cons_paths), curr_time(curr_time), agents(agents), focal_w(f_w),
+ECBSSearch::ECBSSearch(const vector<bool> &my_map, vector<Agent*> &agents, const PathReservations &cons_paths, 
+						int curr_time, int col, double f_w, double time_limit)
+	:curr_time(curr_time), agents(agents), focal_w(f_w),
 	HL_num_expanded(0), HL_num_generated(0), LL_num_expanded(0), LL_num_generated(0),
-	solution_found(false), solution_cost(-1)
+	solution_found(false), solution_cost(-1), time_limit(time_limit), timed_out(false),
+	best_node(NULL), best_num_collisions(INT_MAX), collision_table(my_map.size())
 {
 
   num_of_agents = agents.size();
@@ -347,36 +292,26 @@ ECBSSearch::ECBSSearch(const vector<bool> &my_map, vector<Agent*> &agents, const
 		  agents[i]->id, agents[i]->loc, agents[i]->next_ep->loc, col, curr_time, agents[0]->path.size());
   }
 
-  // initialize allNodes_table (hash table)
-  empty_node = new ECBSNode();
-  empty_node->time_generated = -2; empty_node->agent_id = -2;
-  deleted_node = new ECBSNode();
-  deleted_node->time_generated = -3; deleted_node->agent_id = -3;
-  allNodes_table.set_empty_key(empty_node);
-  allNodes_table.set_deleted_key(deleted_node);
-
   // initialize all initial paths to NULL
-  paths_found_initially.resize(num_of_agents);
-  for (int ag = 0; ag < num_of_agents; ag++)
-	  paths_found_initially[ag].clear();
+  paths_found_initially.assign(num_of_agents, path_ptr_t());
 
   // initialize paths_found_initially
   for (int i = 0; i < num_of_agents; i++) {
     //    cout << "Computing initial path for agent " << i << endl; fflush(stdout);
     paths = paths_found_initially;
     size_t max_plan_len = getPathsMaxLength();
-    bool* res_table = new bool[map_size * max_plan_len]();  // initialized to false
+    ReservationTable& res_table = res_tables[0];
+    res_table.resize(map_size, max_plan_len);
     updateReservationTable(res_table, max_plan_len, i);
     //    cout << "*** CALCULATING INIT PATH FOR AGENT " << i << ". Reservation Table[MAP_SIZE x MAX_PLAN_LEN]: " << endl;
-    //    printResTable(res_table, max_plan_len);
-    if ( search_engines[i]->findPath ( f_w, NULL, res_table, max_plan_len ) == false)
+    //    printResTable(res_table.data(), max_plan_len);
+    if ( search_engines[i]->findPath ( f_w, NULL, res_table.data(), max_plan_len ) == false)
       cout << "NO SOLUTION EXISTS";
-    paths_found_initially[i] = search_engines[i]->path;
+    paths_found_initially[i] = std::make_shared<const vector<int> >(search_engines[i]->path);
     ll_min_f_vals_found_initially[i] = search_engines[i]->min_f_val;
     paths_costs_found_initially[i] = search_engines[i]->path_cost;
     LL_num_expanded += search_engines[i]->num_expanded;
     LL_num_generated += search_engines[i]->num_generated;
-    delete[] res_table;
     //    cout << endl;
   }
 
@@ -392,7 +327,7 @@ ECBSSearch::ECBSSearch(const vector<bool> &my_map, vector<Agent*> &agents, const
     dummy_start->g_val += paths_costs[i];
   dummy_start->ll_min_f_val = 0;
   dummy_start->sum_min_f_vals = compute_hl_lower_bound();
-  dummy_start->open_handle = open_list.push(dummy_start);
+  open_list.push(dummy_start);
   dummy_start->focal_handle = focal_list.push(dummy_start);
   HL_num_generated++;
   dummy_start->time_generated = HL_num_generated;
@@ -408,25 +343,25 @@ ECBSSearch::ECBSSearch(const vector<bool> &my_map, vector<Agent*> &agents, const
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 bool ECBSSearch::runECBSSearch() {
-  // set timer
-  std::clock_t start;
+  // set timer (wall-clock, so that the budget bounds the latency of a planning call)
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
   double duration;
-  start = std::clock();
 
   // start is already in the open_list
   while ( !focal_list.empty() && !solution_found ) {
-    // break after 5 min
-    duration = (std::clock() - start) / (double) CLOCKS_PER_SEC;
-    if (duration > 500) {  // timeout after 5 minutes
+    // break after time_limit
+    duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (duration > time_limit) {
       cout << "TIMEOUT  ; " << solution_cost << " ; " << min_sum_f_vals << " ; " <<
           HL_num_expanded << " ; " << HL_num_generated << " ; " <<
           LL_num_expanded << " ; " << LL_num_generated << " ; " << duration << endl;
-      return false;
+      timed_out = true;
+      break;
     }
 
     ECBSNode* curr = focal_list.top();
     focal_list.pop();
-    open_list.erase(curr->open_handle);
+    open_list.erase(curr);
     HL_num_expanded++;
     curr->time_expanded = HL_num_expanded;
     //    cout << "Expanding: (" << curr << ")" << *curr << " at time:" << HL_num_expanded << endl;
@@ -446,6 +381,11 @@ bool ECBSSearch::runECBSSearch() {
     cout << "Overall Col_Vec.size=" << collision_vec->size() << endl;
      */
 
+    if ( collision_table.getNumOfCollidingAgents() < best_num_collisions ) {
+      best_num_collisions = collision_table.getNumOfCollidingAgents();
+      best_node = curr;
+    }
+
     if ( collision_vec->size() == 0 ) {  // found a solution (and finish the while look)
       solution_found = true;
       solution_cost = curr->g_val;
@@ -469,19 +409,29 @@ bool ECBSSearch::runECBSSearch() {
       }
       n1->parent = curr;
       n2->parent = curr;
+      // the two children constrain different agents (hence use different search engines) and only read paths,
+      // so they are replanned concurrently. They are then added to OPEN/FOCAL in order, as before.
+      ECBSNode* children[2] = { n1, n2 };
+      bool child_found[2];
+#pragma omp parallel for num_threads(2) schedule(static)
+      for (int i = 0; i < 2; i++) {
+        // build the constraints on this agent and compute (and store) a path satisfying them
+        child_found[i] = updateECBSNode(children[i], res_tables[i]);
+        // re-check only the child's agent against the paths of curr
+        if (child_found[i])
+          children[i]->h_val = computeNumOfCollidingAgents(children[i]->agent_id, *children[i]->path);
+      }
+      for (int i = 0; i < 2; i++) {
+        LL_num_expanded += search_engines[children[i]->agent_id]->num_expanded;
+        LL_num_generated += search_engines[children[i]->agent_id]->num_generated;
+      }
       //      cout << "*** Before solving, " << endl << *n1;
-      // find all constraints on this agent (recursing to the root) and compute (and store) a path satisfying them. Also updates n1's g_val
-      if ( updateECBSNode(n1, dummy_start) == true ) {
+      if ( child_found[0] ) {
         // new g_val equals old g_val plus the new path length found for the agent minus its old path length
         n1->g_val = curr->g_val - paths_costs[n1->agent_id] + n1->path_cost;
-        // update n1's path for computing the num of colliding agents
-        vector<int> temp_old_path = paths[n1->agent_id];
-        paths[n1->agent_id] = (n1->path);
-        n1->h_val = computeNumOfCollidingAgents();
-        paths[n1->agent_id] = temp_old_path;  // restore the old path (for n2)
         // update lower bounds and handles
         n1->sum_min_f_vals = curr->sum_min_f_vals - ll_min_f_vals[n1->agent_id] + n1->ll_min_f_val;
-        n1->open_handle = open_list.push(n1);
+        open_list.push(n1);
         HL_num_generated++;
         n1->time_generated = HL_num_generated;
         if ( n1->sum_min_f_vals <= focal_list_threshold )
@@ -495,14 +445,10 @@ bool ECBSSearch::runECBSSearch() {
       }
       // same for n2
       //      cout << "*** Before solving, " << endl << *n2;
-      if ( updateECBSNode(n2, dummy_start) == true ) {
+      if ( child_found[1] ) {
         n2->g_val = curr->g_val - paths_costs[n2->agent_id] + n2->path_cost;
-        vector<int> temp_old_path = paths[n2->agent_id];
-        paths[n2->agent_id] = (n2->path);
-        n2->h_val = computeNumOfCollidingAgents();
-        paths[n2->agent_id] = temp_old_path;
         n2->sum_min_f_vals = curr->sum_min_f_vals - ll_min_f_vals[n2->agent_id] + n2->ll_min_f_val;
-        n2->open_handle = open_list.push(n2);
+        open_list.push(n2);
         HL_num_generated++;
         n2->time_generated = HL_num_generated;
         if ( n2->sum_min_f_vals <= focal_list_threshold )
@@ -538,7 +484,16 @@ bool ECBSSearch::runECBSSearch() {
   }  // end of while loop
 
   // get time
-  duration = (std::clock() - start) / (double) CLOCKS_PER_SEC;
+  duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // best effort -- return the least-conflicting paths found (the initial ones if nothing was expanded)
+  if (!solution_found) {
+    if (best_node == NULL)
+      best_node = dummy_start;
+    updatePaths(best_node, dummy_start);
+    delete extractCollisions();  // (re)builds collision_table for these paths
+    best_num_collisions = collision_table.getNumOfCollidingAgents();
+  }
 
   /*
   if (solution_found)
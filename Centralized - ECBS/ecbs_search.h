@@ -5,7 +5,7 @@
 #include <cmath>
 
 #include <boost/heap/fibonacci_heap.hpp>
-#include <google/dense_hash_map>
+#include <unordered_map>
 #include <cstring>
 #include <climits>
 #include <tuple>
@@ -16,12 +16,15 @@
 #include "Agent.h"
 #include "single_agent_ecbs.h"
 #include "ecbs_node.h"
+#include "collision_table.h"
+#include "reservation_table.h"
+#include "path_reservations.h"
 
 using boost::heap::fibonacci_heap;
 using boost::heap::compare;
 using std::cout;
 using std::endl;
-using google::dense_hash_map;
+using std::unordered_map;
 
 class ECBSSearch {
  public:
@@ -29,15 +32,22 @@ class ECBSSearch {
   double focal_list_threshold;
   double min_sum_f_vals;
 
-  typedef boost::heap::fibonacci_heap< ECBSNode* , boost::heap::compare<ECBSNode::compare_node> > heap_open_t;
+  typedef BucketedOpenList< ECBSNode, ECBSNode::open_key > heap_open_t;
   typedef boost::heap::fibonacci_heap< ECBSNode* , boost::heap::compare<ECBSNode::secondary_compare_node> > heap_focal_t;
-  typedef dense_hash_map<ECBSNode*, ECBSNode*, ECBSNode::ECBSNodeHasher, ECBSNode::ecbs_eqnode> hashtable_t;
+  typedef unordered_map<ECBSNode*, ECBSNode*, ECBSNode::ECBSNodeHasher, ECBSNode::ecbs_eqnode> hashtable_t;
 
-  vector < vector<int> > paths;  // agents paths
-  vector < vector<int> > paths_found_initially;  // contain initial paths found
+  vector < path_ptr_t > paths;  // agents paths (shared with the high-level nodes that found them)
+  vector < path_ptr_t > paths_found_initially;  // contain initial paths found
 
   bool solution_found;
   double solution_cost;
+  double time_limit;  // wall-clock budget of runECBSSearch (seconds)
+  bool timed_out;  // runECBSSearch stopped because time_limit elapsed
+
+  // the expanded node whose paths have the fewest colliding pairs (paths are set to it when no solution is found,
+  // or to dummy_start if no node was expanded)
+  ECBSNode* best_node;
+  int best_num_collisions;
 
   ECBSNode* dummy_start;
   vector <int> start_locations;
@@ -60,8 +70,6 @@ class ECBSSearch {
   hashtable_t allNodes_table;
 
   // used in hash table and would be deleted from the d'tor
-  ECBSNode* empty_node;
-  ECBSNode* deleted_node;
 
   vector < SingleAgentECBS* > search_engines;  // used to find (single) agents' paths
   vector <double> ll_min_f_vals_found_initially;  // contains initial ll_min_f_vals found
@@ -70,13 +78,20 @@ class ECBSSearch {
   vector <double> paths_costs;
 
   tuple<int, int, int, int, int> earliest_conflict;  // saves the earliest conflict (updated in every call to extractCollisions()).
+  CollisionTable collision_table;  // spatial hash of the paths (rebuilt in every call to extractCollisions())
+  vector < std::shared_ptr<const ConstraintTable> > constraint_tables;  // each agent's constraints (updated with paths in updatePaths())
+  ReservationTable res_tables[2];  // one per child generated concurrently
 
-  ECBSSearch(const vector<bool> &my_map, vector<Agent*> &agents, const vector<vector<int> > &cons_paths,
-	  int curr_time, int col, double f_w);
+  // Note -- my_map and cons_paths are shared (not copied) by the low-level engines and must outlive the search.
+  ECBSSearch(const vector<bool> &my_map, vector<Agent*> &agents, const PathReservations &cons_paths,
+	  int curr_time, int col, double f_w, double time_limit = 500);
   inline double compute_g_val();
   inline double compute_hl_lower_bound();
   inline void updatePaths(ECBSNode* curr , ECBSNode* root_node);
-  inline bool updateECBSNode(ECBSNode* leaf_node, ECBSNode* root_node);
+  inline bool updateECBSNode(ECBSNode* leaf_node, ReservationTable& res_table);
+  /* Returns true iff a collision-free solution is found (then stored in paths).
+     Otherwise (time_limit elapsed or no more nodes) paths hold the best partial solution (see best_node).
+  */
   bool runECBSSearch();
   inline bool switchedLocations(int agent1_id, int agent2_id, size_t timestep);
   inline int getAgentLocation(int agent_id, size_t timestep);
@@ -86,11 +101,12 @@ class ECBSSearch {
   void updatePathsForExpTime(int t_exp);
 
   size_t getPathsMaxLength();
-  void updateReservationTable(bool* res_table, size_t max_plan_len, int exclude_agent);
+  void updateReservationTable(ReservationTable& res_table, size_t max_plan_len, int exclude_agent);
 
   void updateFocalList(double old_lower_bound, double new_lower_bound, double f_weight);
 
   int computeNumOfCollidingAgents();
+  int computeNumOfCollidingAgents(int agent_id, const vector<int>& new_path);
 
   inline void releaseClosedListNodes();
 
@@ -98,7 +114,6 @@ class ECBSSearch {
 
 private:
 	int curr_time;
-	const vector<vector<int> > cons_paths;
 	vector<Agent*> agents;
 };
 
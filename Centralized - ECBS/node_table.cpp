@@ -0,0 +1,64 @@
+#include "node_table.h"
+
+
+NodeTable::NodeTable() : slots(1024), num_entries(0), generation(1) {
+  for (size_t i = 0; i < slots.size(); i++)
+    slots[i].generation = 0;
+}
+
+
+void NodeTable::clear() {
+  num_entries = 0;
+  if (++generation == 0) {  // wrapped around -- old stamps could be mistaken for current ones
+    for (size_t i = 0; i < slots.size(); i++)
+      slots[i].generation = 0;
+    generation = 1;
+  }
+}
+
+
+Node* NodeTable::find(uint64_t key) const {
+  size_t mask = slots.size() - 1;
+  for (size_t i = hash(key) & mask; slots[i].generation == generation; i = (i + 1) & mask)
+    if (slots[i].key == key)
+      return slots[i].node;
+  return NULL;
+}
+
+
+void NodeTable::insert(uint64_t key, Node* node) {
+  if (2 * (num_entries + 1) > slots.size())  // keep the load factor under 1/2
+    grow();
+  size_t mask = slots.size() - 1;
+  size_t i = hash(key) & mask;
+  while (slots[i].generation == generation)
+    i = (i + 1) & mask;
+  slots[i].key = key;
+  slots[i].node = node;
+  slots[i].generation = generation;
+  num_entries++;
+}
+
+
+void NodeTable::grow() {
+  std::vector<Slot> old_slots(slots.size() * 2);
+  old_slots.swap(slots);
+  for (size_t i = 0; i < slots.size(); i++)
+    slots[i].generation = 0;
+  unsigned int old_generation = generation;
+  generation = 1;
+  num_entries = 0;
+  for (size_t i = 0; i < old_slots.size(); i++)
+    if (old_slots[i].generation == old_generation)
+      insert(old_slots[i].key, old_slots[i].node);
+}
+
+
+Node* NodePool::allocate(int loc, double g_val, double h_val, Node* parent, int timestep, int num_internal_conf) {
+  if (used == nodes.size()) {
+    nodes.push_back(Node(loc, g_val, h_val, parent, timestep, num_internal_conf, false));
+  } else {
+    nodes[used] = Node(loc, g_val, h_val, parent, timestep, num_internal_conf, false);
+  }
+  return &nodes[used++];
+}
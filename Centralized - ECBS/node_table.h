@@ -0,0 +1,56 @@
+// Node storage for the low-level search (reused between calls to SingleAgentECBS::findPath)
+#ifndef NODETABLE_H
+#define NODETABLE_H
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include "Node.h"
+
+/* Open-addressing hash table from an integer key (timestep*map_size+loc) to a node.
+   Slots are stamped with the generation they were written in, so clear() is O(1).
+*/
+class NodeTable {
+ public:
+  NodeTable();
+
+  void clear();
+  Node* find(uint64_t key) const;
+  // Note -- key must not be in the table already
+  void insert(uint64_t key, Node* node);
+
+ private:
+  struct Slot {
+    uint64_t key;
+    Node* node;
+    unsigned int generation;
+  };
+
+  static inline size_t hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (size_t)key;
+  }
+  void grow();
+
+  std::vector<Slot> slots;  // size is a power of 2
+  size_t num_entries;
+  unsigned int generation;
+};
+
+/* Nodes handed out by allocate() stay valid until clear(); their memory is then recycled.
+ */
+class NodePool {
+ public:
+  NodePool() : used(0) {}
+
+  Node* allocate(int loc, double g_val, double h_val, Node* parent, int timestep, int num_internal_conf);
+  void clear() { used = 0; }
+
+ private:
+  std::deque<Node> nodes;  // deque keeps nodes at a fixed address while growing
+  size_t used;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#include "path_reservations.h"
+
+
+PathReservations::PathReservations(int map_size, int from_timestep)
+  : map_size(map_size), from_timestep(from_timestep), num_paths(0) {
+}
+
+
+void PathReservations::addPath(const vector<int>& path) {
+  if (path.empty())
+    return;
+  num_paths++;
+  // the agent stays at path.back() from last_move onwards
+  int last_move = path.size() - 1;
+  while (last_move > 0 && path[last_move - 1] == path.back())
+    last_move--;
+
+  int start = from_timestep > 0 ? from_timestep : 0;
+  for (int t = start; t < last_move; t++) {
+    vertices.insert(vertexKey(path[t], t));
+    int& last = last_time.insert(std::make_pair(path[t], t)).first->second;
+    if (t > last)
+      last = t;
+  }
+  for (int t = start > 0 ? start : 1; t <= last_move; t++)
+    if (path[t - 1] != path[t])
+      edges.insert(edgeKey(path[t - 1], path[t], t));
+
+  int& hold = hold_from.insert(std::make_pair(path.back(), last_move)).first->second;
+  if (last_move < hold)
+    hold = last_move;
+  int& last = last_time.insert(std::make_pair(path.back(), (int)path.size() - 1)).first->second;
+  if ((int)path.size() - 1 > last)
+    last = path.size() - 1;
+}
+
+
+int PathReservations::getLastOccupiedTime(int loc) const {
+  unordered_map<int, int>::const_iterator it = last_time.find(loc);
+  return it == last_time.end() ? -1 : it->second;
+}
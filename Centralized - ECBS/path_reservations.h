@@ -0,0 +1,57 @@
+// Paths of agents planned before (e.g., delivering agents), shared read-only by every low-level search
+#ifndef PATHRESERVATIONS_H
+#define PATHRESERVATIONS_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+using std::vector;
+using std::unordered_map;
+using std::unordered_set;
+
+class PathReservations {
+ public:
+  /* Only timesteps >= from_timestep are recorded (earlier ones cannot be planned for anymore).
+   */
+  PathReservations(int map_size, int from_timestep);
+
+  /* Adds the path of an agent (its location at every timestep of the simulation).
+     The agent holds its last location from its last move onwards, which is stored once instead of per timestep.
+  */
+  void addPath(const vector<int>& path);
+
+  // true iff some agent is at loc at timestep
+  inline bool isOccupied(int loc, int timestep) const {
+    unordered_map<int, int>::const_iterator it = hold_from.find(loc);
+    if (it != hold_from.end() && it->second <= timestep)
+      return true;
+    return vertices.count(vertexKey(loc, timestep)) > 0;
+  }
+
+  // true iff some agent moves from next_loc to curr_loc at [next_timestep-1,next_timestep] (edge collision)
+  inline bool isMoveBlocked(int curr_loc, int next_loc, int next_timestep) const {
+    return !edges.empty() && edges.count(edgeKey(next_loc, curr_loc, next_timestep)) > 0;
+  }
+
+  // latest timestep at which some agent is at loc (-1 if none)
+  int getLastOccupiedTime(int loc) const;
+
+  size_t size() const { return num_paths; }
+
+ private:
+  inline uint64_t vertexKey(int loc, int timestep) const { return (uint64_t)timestep * map_size + loc; }
+  inline uint64_t edgeKey(int from, int to, int timestep) const { return vertexKey(from, timestep) * map_size + to; }
+
+  int map_size;
+  int from_timestep;
+  size_t num_paths;
+  unordered_set<uint64_t> vertices;  // (timestep*map_size+loc) before the agent's last move
+  unordered_set<uint64_t> edges;  // moves ((timestep*map_size+from)*map_size+to), arriving at to at timestep
+  unordered_map<int, int> hold_from;  // loc -> earliest timestep from which an agent stays there
+  unordered_map<int, int> last_time;  // loc -> latest timestep at which an agent is there
+};
+
+#endif
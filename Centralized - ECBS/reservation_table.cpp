@@ -0,0 +1,38 @@
+#include "reservation_table.h"
+
+
+ReservationTable::ReservationTable() : table(NULL), capacity(0), map_size(0), max_plan_len(0) {
+}
+
+
+void ReservationTable::resize(size_t map_size, size_t max_plan_len) {
+  clear();
+  if (map_size * max_plan_len > capacity) {
+    delete[] table;
+    capacity = map_size * max_plan_len;
+    table = new bool[capacity]();  // initialized to false
+  }
+  this->map_size = map_size;
+  this->max_plan_len = max_plan_len;
+}
+
+
+void ReservationTable::reserve(int loc, size_t timestep) {
+  size_t id = loc + timestep * map_size;
+  if (!table[id]) {
+    table[id] = true;
+    reserved.push_back(id);
+  }
+}
+
+
+void ReservationTable::clear() {
+  for (size_t i = 0; i < reserved.size(); i++)
+    table[reserved[i]] = false;
+  reserved.clear();
+}
+
+
+ReservationTable::~ReservationTable() {
+  delete[] table;
+}
@@ -0,0 +1,43 @@
+// Reusable reservation table for the low-level search
+#ifndef RESERVATIONTABLE_H
+#define RESERVATIONTABLE_H
+
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+class ReservationTable {
+ public:
+  ReservationTable();
+  ~ReservationTable();
+
+  /* Makes room for a cube of map_size*max_plan_len entries.
+     The buffer only grows (it is kept between planning calls) and is always handed out cleared.
+  */
+  void resize(size_t map_size, size_t max_plan_len);
+
+  /* Marks location loc as occupied at timestep.
+   */
+  void reserve(int loc, size_t timestep);
+
+  /* Resets only the entries reserved since the last clear (instead of zeroing the whole cube).
+   */
+  void clear();
+
+  // raw cube in the layout expected by SingleAgentECBS::findPath (res_table[loc + timestep*map_size])
+  bool* data() { return table; }
+  size_t getMaxPlanLength() const { return max_plan_len; }
+
+ private:
+  bool* table;
+  size_t capacity;
+  size_t map_size;
+  size_t max_plan_len;
+  vector<size_t> reserved;  // indices set since the last clear
+
+  ReservationTable(const ReservationTable&);
+  ReservationTable& operator=(const ReservationTable&);
+};
+
+#endif
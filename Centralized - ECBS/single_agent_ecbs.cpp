@@ -16,9 +16,9 @@ using std::endl;
 using boost::heap::fibonacci_heap;
 
 
-SingleAgentECBS::SingleAgentECBS(const vector<vector<int> > &cons_paths, const vector<int> &my_heuristic, const vector<bool> &my_map,
+SingleAgentECBS::SingleAgentECBS(const PathReservations &reservations, const vector<int> &my_heuristic, const vector<bool> &my_map,
 	int ag_id, int start_location, int goal_location, int col, int curr_time, int max_time) :
-		cons_paths(cons_paths), my_heuristic(my_heuristic), my_map(my_map), ag_id(ag_id), start_location(start_location), goal_location(goal_location), curr_time(curr_time), 
+		reservations(&reservations), my_heuristic(&my_heuristic), my_map(my_map), ag_id(ag_id), start_location(start_location), goal_location(goal_location), curr_time(curr_time), 
 		num_expanded(0), num_generated(0), path_cost(0), lower_bound(0), min_f_val(0), num_non_hwy_edges(0), max_time(max_time)
 	{
  
@@ -35,6 +35,18 @@ SingleAgentECBS::SingleAgentECBS(const vector<vector<int> > &cons_paths, const v
 }
 
 
+void SingleAgentECBS::reset(int ag_id, int start_location, int goal_location, const vector<int> &my_heuristic) {
+  this->ag_id = ag_id;
+  this->start_location = start_location;
+  this->goal_location = goal_location;
+  this->my_heuristic = &my_heuristic;
+  path.clear();
+  path_cost = 0;
+  lower_bound = 0;
+  min_f_val = 0;
+}
+
+
 void SingleAgentECBS::updatePath(Node* goal) {
   path.clear();
   Node* curr = goal;
@@ -49,73 +61,61 @@ void SingleAgentECBS::updatePath(Node* goal) {
   path_cost = goal->g_val;
 }
 
-inline void SingleAgentECBS::releaseClosedListNodes(map<unsigned int, Node*> &allNodes_table) {
-   map<unsigned int, Node*>::iterator it;
-  for (it=allNodes_table.begin(); it != allNodes_table.end(); it++) {
-    delete ( (*it).second );  // Node* s = (*it).first; delete (s);
-  }
+// nodes are kept in node_pool and recycled by the next search (instead of being deleted one by one)
+inline void SingleAgentECBS::releaseClosedListNodes() {
   allNodes_table.clear();
+  node_pool.clear();
 }
 
 
-// iterate over the constraints ( cons[t] is a list of all constraints for timestep t) and return the latest
-// timestep which has a constraint involving the goal location
-int SingleAgentECBS::extractLastGoalTimestep(int goal_location, const vector< list< pair<int, int> > >* cons) {
+// return the latest timestep (>0) which has a constraint involving the goal location
+int SingleAgentECBS::extractLastGoalTimestep(int goal_location, const ConstraintTable* cons) {
   if (cons != NULL) {
-    for ( int t = static_cast<int>(cons->size())-1; t > 0; t-- ) {
-      for (list< pair<int, int> >::const_iterator it = cons->at(t).begin(); it != cons->at(t).end(); ++it) {
-        // $$$: in the following if, do we need to check second (maybe cannot happen in edge constraints?)
-        if ((*it).first == goal_location || (*it).second == goal_location) {
-          return (t);
-        }
-      }
-    }
+    int t = cons->getLatestTimestep(goal_location);
+    if (t > 0)
+      return t;
   }
   return -1;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // input: curr_id (location at time next_timestep-1) ; next_id (location at time next_timestep); next_timestep
-//        cons[timestep] is a list of <loc1,loc2> of (vertex/edge) constraints for that timestep.
-inline bool SingleAgentECBS::isConstrained(int curr_loc, int next_loc, int next_timestep, const vector< list< pair<int, int> > >* cons) 
+//        cons holds the (vertex/edge) constraints on this agent.
+inline bool SingleAgentECBS::isConstrained(int curr_loc, int next_loc, int next_timestep, const ConstraintTable* cons) 
 {
 	//check whether it is a block
 	if (!my_map[next_loc]) return true;
 
 	//cheack constraints with DELIVER agents
-	for (unsigned int i = 0; i < cons_paths.size(); i++)
-	{
-		if (cons_paths[i][curr_time + next_timestep] == next_loc)
-			return true; //vertext collision
-		else if (cons_paths[i][curr_time + next_timestep] == curr_loc &&cons_paths[i][curr_time + next_timestep - 1] == next_loc)
-			return true; //edge collision
-	}
+	if (reservations->isOccupied(next_loc, curr_time + next_timestep))
+		return true; //vertext collision
+	if (reservations->isMoveBlocked(curr_loc, next_loc, curr_time + next_timestep))
+		return true; //edge collision
 
   //  cout << "check if ID="<<id<<" is occupied at TIMESTEP="<<timestep<<endl;
   if (cons == NULL)
     return false;
 
   // check vertex constraints (being in next_loc at next_timestep is disallowed)
-  if ( next_timestep < static_cast<int>(cons->size()) ) {
-    for ( list< pair<int, int> >::const_iterator it = cons->at(next_timestep).begin(); it != cons->at(next_timestep).end(); ++it ) {
-      if ( (*it).second == -1 ) {
-        if ( (*it).first == next_loc ) {
-          return true;
-        }
-      }
-    }
-  }
-
-  // check edge constraints (the move from curr_id to next_id at next_timestep-1 is disallowed)
-  if ( next_timestep > 0 && next_timestep - 1 < static_cast<int>(cons->size()) ) {
-    for ( list< pair<int, int> >::const_iterator it = cons->at(next_timestep-1).begin(); it != cons->at(next_timestep-1).end(); ++it ) {
-      if ( (*it).first == curr_loc && (*it).second == next_loc ) {
-        return true;
-      }
-    }
-  }
+  if (!vertex_cons.empty() && vertex_cons.count((uint64_t)next_timestep * map_size + next_loc))
+    return true;
+  // and edge constraints (the move from curr_id to next_id at next_timestep-1 is disallowed)
+  return next_timestep > 0 && !edge_cons.empty() &&
+         edge_cons.count(((uint64_t)(next_timestep - 1) * map_size + curr_loc) * map_size + next_loc);
+}
 
-  return false;
+void SingleAgentECBS::loadConstraints(const ConstraintTable* cons) {
+  vertex_cons.clear();
+  edge_cons.clear();
+  if (cons == NULL)
+    return;
+  cons->visitAll([this](int loc1, int loc2, int timestep) {
+    uint64_t key = (uint64_t)timestep * map_size + loc1;
+    if (loc2 == -1)
+      vertex_cons.insert(key);
+    else
+      edge_cons.insert(key * map_size + loc2);
+  });
 }
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -141,54 +141,47 @@ int SingleAgentECBS::numOfConflictsForStep(int curr_id, int next_id, int next_ti
   return retVal;
 }
 
-// $$$ -- is there a more efficient way to do that?
 void SingleAgentECBS::updateFocalList(double old_lower_bound, double new_lower_bound, double f_weight) {
   //  cout << "Update Focal: (old_LB=" << old_lower_bound << " ; new_LB=" << new_lower_bound << endl;;
-  for (Node* n : open_list) {
-    //    cout << "   Considering " << n << " , " << *n << endl;
-    if ( n->getFVal() > old_lower_bound &&
-         n->getFVal() <= new_lower_bound ) {
-      //      cout << "      Added (n->f-val=" << n->getFVal() << ")" << endl;
-      n->focal_handle = focal_list.push(n);
-    }
-  }
+  open_list.visitRange(old_lower_bound, new_lower_bound, [this](Node* n) {
+    n->focal_handle = focal_list.push(n);
+  });
 }
 
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // return true if a path found (and updates vector<int> path) or false if no path exists
-bool SingleAgentECBS::findPath(double f_weight, const vector < list< pair<int, int> > >* constraints, bool* res_table, size_t max_plan_len) {
+bool SingleAgentECBS::findPath(double f_weight, const ConstraintTable* constraints, bool* res_table, size_t max_plan_len) {
   // clear data structures if they had been used before
-  // (note -- nodes are deleted before findPath returns)
+  // (note -- nodes are released before findPath returns)
   open_list.clear();
   focal_list.clear();
-  //allNodes_table.clear();
-  map<unsigned int, Node*> allNodes_table; //int=g_val*map_size+loc
+  releaseClosedListNodes();
   num_expanded = 0;
   num_generated = 0;
 
   //hashtable_t::iterator it;  // will be used for find()
 
   // generate start and add it to the OPEN list
-  Node* start = new Node(start_location, 0, my_heuristic[start_location], NULL, 0, 0, false);
+  Node* start = node_pool.allocate(start_location, 0, (*my_heuristic)[start_location], NULL, 0, 0);
   num_generated++;
-  start->open_handle = open_list.push(start);
+  open_list.push(start);
   start->focal_handle = focal_list.push(start);
   start->in_openlist = true;
-  //allNodes_table[start] = start;
-  allNodes_table.insert(make_pair(start_location, start)); //g_val=0
+  allNodes_table.insert(start_location, start);  // timestep=0
   min_f_val = start->getFVal();
   lower_bound = f_weight * min_f_val;
 
   int lastGoalConsTime = extractLastGoalTimestep(goal_location, constraints);
+  loadConstraints(constraints);
 
   while ( !focal_list.empty() ) {
     //    cout << "|F|=" << focal_list.size() << " ; |O|=" << open_list.size() << endl;
     Node* curr = focal_list.top(); focal_list.pop();
     //    cout << "Current FOCAL bound is " << lower_bound << endl;
     //    cout << "POPPED FOCAL's HEAD: (" << curr << ") " << (*curr) << endl;
-    open_list.erase(curr->open_handle);
+    open_list.erase(curr);
     //    cout << "DELETED" << endl; fflush(stdout);
     curr->in_openlist = false;
      num_expanded++;
@@ -196,22 +189,10 @@ bool SingleAgentECBS::findPath(double f_weight, const vector < list< pair<int, i
     // check if the popped node is a goal
     if (curr->loc == goal_location && curr->timestep > lastGoalConsTime) 
 	{
-		//chack whether it can be held
-		bool hold = true;
-		for (unsigned int ag = 0; ag < cons_paths.size() && hold == true; ag++)
-		{
-			for (unsigned int t = curr->timestep + curr_time + 1; t < cons_paths[ag].size() && hold == true; t++)
-			{
-				if (cons_paths[ag][t] == curr->loc)
-				{
-					hold = false;
-				}
-			}
-		}
-		if (hold)
+		//chack whether it can be held (no DELIVER agent comes by later)
+		if (reservations->getLastOccupiedTime(curr->loc) <= curr->timestep + curr_time)
 		{
 			updatePath(curr);
-			releaseClosedListNodes(allNodes_table);
 			return true;
 		}
     }
@@ -228,31 +209,29 @@ bool SingleAgentECBS::findPath(double f_weight, const vector < list< pair<int, i
 			//   cost = 0.5;
 			// }
 			double next_g_val = curr->g_val + cost;
-			double next_h_val = my_heuristic[next_id];
+			double next_h_val = (*my_heuristic)[next_id];
 			int next_internal_conflicts = 0;
 			if (max_plan_len > 0)  // check if the reservation table is not empty (that is tha max_length of any other agent's plan is > 0)
 				next_internal_conflicts = curr->num_internal_conf + numOfConflictsForStep(curr->loc, next_id, next_timestep, res_table, max_plan_len);
-			// generate (maybe temporary) node
-			Node* next = new Node(next_id, next_g_val, next_h_val, curr, next_timestep, next_internal_conflicts, false);
-			       // cout << "   NEXT(" << next << ")=" << *next << endl;
-			// try to retrieve it from the hash table
-			//it = allNodes_table.find(next);
-			map<unsigned int, Node* >::iterator it = allNodes_table.find(next->loc + next->g_val*my_map.size());
-
-			if (it == allNodes_table.end() && next->g_val<max_time - curr_time) {  // add the newly generated node to open_list and hash table
+			// try to retrieve it from the hash table (nodes are identified by <loc,timestep>)
+			uint64_t next_key = (uint64_t)next_timestep * map_size + next_id;
+			Node* existing_next = allNodes_table.find(next_key);
+
+			if (existing_next == NULL) {
+				if (next_g_val >= max_time - curr_time)
+					continue;  // beyond the simulation horizon
+				// add the newly generated node to open_list and hash table
+				Node* next = node_pool.allocate(next_id, next_g_val, next_h_val, curr, next_timestep, next_internal_conflicts);
 				//          cout << "   ADDING it as new." << endl;
-				next->open_handle = open_list.push(next);
+				open_list.push(next);
 				next->in_openlist = true;
 				num_generated++;
 				if (next->getFVal() <= lower_bound)
 					next->focal_handle = focal_list.push(next);
-				//allNodes_table[next] = next;
-				allNodes_table.insert(pair<unsigned int, Node*>(next->loc + next->g_val*my_map.size(), next));
+				allNodes_table.insert(next_key, next);
 
 			}
 			else {  // update existing node's if needed (only in the open_list)
-				delete(next);  // not needed anymore -- we already generated it before
-				Node* existing_next = (*it).second;
 				//          cout << "Actually next exists. It's address is " << existing_next << endl;
 				if (existing_next->in_openlist == true) {  // if its in the open list
 					if (existing_next->getFVal() > next_g_val + next_h_val ||
@@ -271,6 +250,8 @@ bool SingleAgentECBS::findPath(double f_weight, const vector < list< pair<int, i
 						}
 						if (existing_next->getFVal() > next_g_val + next_h_val)
 							update_open = true;
+						if (update_open)
+							open_list.erase(existing_next);  // f-val improved (it is re-bucketed below)
 						// update existing node
 						existing_next->g_val = next_g_val;
 						existing_next->h_val = next_h_val;
@@ -278,7 +259,7 @@ bool SingleAgentECBS::findPath(double f_weight, const vector < list< pair<int, i
 						existing_next->num_internal_conf = next_internal_conflicts;
 						//              cout << "   Node state after update: " << *existing_next;
 						if (update_open) {
-							open_list.increase(existing_next->open_handle);  // increase because f-val improved
+							open_list.push(existing_next);
 							//                cout << "     Increased in OPEN" << endl;
 						}
 						if (add_to_focal) {
@@ -302,7 +283,7 @@ bool SingleAgentECBS::findPath(double f_weight, const vector < list< pair<int, i
 						existing_next->h_val = next_h_val;
 						existing_next->parent = curr;
 						existing_next->num_internal_conf = next_internal_conflicts;
-						existing_next->open_handle = open_list.push(existing_next);
+						open_list.push(existing_next);
 						existing_next->in_openlist = true;
 						//              cout << "   Node state after update: " << *existing_next;
 						if (existing_next->getFVal() <= lower_bound) {
@@ -348,7 +329,6 @@ bool SingleAgentECBS::findPath(double f_weight, const vector < list< pair<int, i
   }  // end while loop
   // no path found
   path.clear();
-  releaseClosedListNodes(allNodes_table);
   return false;
 }
 
@@ -2,36 +2,34 @@
 #define SINGLEAGENTECBS_H
 
 #include <stdlib.h>
+#include <stdint.h>
 
 #include <vector>
 #include <list>
 #include <utility>
-#include <sparsehash/dense_hash_map>
 #include <map>
-#include "node.h"
+#include <unordered_set>
+#include "Node.h"
+#include "node_table.h"
+#include "constraint_table.h"
+#include "path_reservations.h"
 
 using std::cout;
-using google::dense_hash_map;
 
 class SingleAgentECBS {
  public:
   // define typedefs (will also be used in ecbs_search)
-  typedef boost::heap::fibonacci_heap< Node* , boost::heap::compare<Node::compare_node> > heap_open_t;
+  typedef BucketedOpenList< Node, Node::open_key > heap_open_t;
   typedef boost::heap::fibonacci_heap< Node* , boost::heap::compare<Node::secondary_compare_node> > heap_focal_t;
   //typedef boost::heap::fibonacci_heap< Node* , boost::heap::compare<Node::secondary_hwy_compare_node> > heap_focal_t;
 
-  typedef dense_hash_map<Node*, Node*, Node::NodeHasher, Node::eqnode> hashtable_t;
-  // note -- hash_map (key is a node pointer, data is a node handler,
-  //                   NodeHasher is the hash function to be used,
-  //                   eqnode is used to break ties when hash values are equal)
-
   vector<int> path;  // a path that takes the agent from initial to goal location satisying all constraints
   // consider changing path from vector to deque (efficient front insertion)
   double path_cost;
   int start_location;
   int goal_location;
   //const double* my_heuristic;  // this is the precomputed heuristic for this agent
-  vector<bool> my_map;
+  const vector<bool>& my_map;  // shared by all engines (owned by the caller)
   int map_size;
   uint64_t num_expanded;
   uint64_t num_generated;
@@ -47,17 +45,22 @@ class SingleAgentECBS {
   //  Node::focal_handle_t focal_handle;
   heap_focal_t focal_list;
 
- // hashtable_t allNodes_table;
+  NodeTable allNodes_table;  // (timestep*map_size+loc) -> node, cleared at the beginning of every findPath
+  NodePool node_pool;  // all nodes generated by findPath (recycled by the next call)
 
   // used in hash table and would be deleted from the d'tor
   //Node* empty_node;
   //Node* deleted_node;
 
   /* ctor
+     Note -- reservations, my_heuristic and my_map are only referenced (not copied) and must outlive the engine.
    */
-  SingleAgentECBS(const vector<vector<int> > &cons_paths, const vector<int> &my_heuristic, const vector<bool> &my_map,
+  SingleAgentECBS(const PathReservations &reservations, const vector<int> &my_heuristic, const vector<bool> &my_map,
 	  int ag_id, int start_location, int goal_location, int col, int curr_time, int max_time);
 
+  /* Re-targets the engine to a new (start, goal) query so that one engine can be reused for many searches.
+  */
+  void reset(int ag_id, int start_location, int goal_location, const vector<int> &my_heuristic);
 
   /* return a pointer to the path found.
    */
@@ -67,15 +70,20 @@ class SingleAgentECBS {
   /* returns the minimal plan length for the agent (that is, extract the latest timestep which
      has a constraint invloving this agent's goal location).
   */
-  int extractLastGoalTimestep(int goal_location, const vector< list< pair<int, int> > >* cons);
+  int extractLastGoalTimestep(int goal_location, const ConstraintTable* cons);
 
-  inline void releaseClosedListNodes(map<unsigned int, Node*> &allNodes_table);
+  inline void releaseClosedListNodes();
+
+  /* Loads the constraints of cons (NULL for none) into vertex_cons and edge_cons, once per search.
+  */
+  void loadConstraints(const ConstraintTable* cons);
 
   /* Checks if a vaild path found (wrt my_map and constraints)
-     Note -- constraint[timestep] is a list of pairs. Each pair is a disallowed <loc1,loc2> (loc2=-1 for vertex constraint).
+     Note -- cons holds the disallowed <loc1,loc2,timestep> (loc2=-1 for vertex constraint), each looked up in O(1)
+     in the sets loaded from it by loadConstraints.
      Returns true/false.
   */
-  inline bool isConstrained(int curr_id, int next_id, int next_timestep, const vector< list< pair<int, int> > >* cons);
+  inline bool isConstrained(int curr_id, int next_id, int next_timestep, const ConstraintTable* cons);
 
   /* Updates the path datamember (vector<int>).
      After update it will contain the sequence of locations found from the goal to the start.
@@ -87,14 +95,15 @@ class SingleAgentECBS {
    */
   int numOfConflictsForStep(int curr_id, int next_id, int next_timestep, bool* res_table, int max_plan_len);
 
-  /* Iterate over OPEN and adds to FOCAL all nodes with: 1) f-val > old_min_f_val ; and 2) f-val * f_weight < new_lower_bound.
+  /* Adds to FOCAL all nodes in OPEN with: 1) f-val > old_min_f_val ; and 2) f-val * f_weight < new_lower_bound.
+     (only the OPEN buckets in that range are visited)
    */
   void updateFocalList(double old_lower_bound, double new_lower_bound, double f_weight);
 
   /* Returns true if a collision free path found (with cost up to f_weight * f-min) while
      minimizing the number of internal conflicts (that is conflicts with known_paths for other agents found so far).
   */
-  bool findPath(double f_weight, const vector < list< pair<int, int> > >* constraints, bool* res_table, size_t max_plan_len);
+  bool findPath(double f_weight, const ConstraintTable* constraints, bool* res_table, size_t max_plan_len);
 
   ~SingleAgentECBS();
 private:
@@ -102,8 +111,10 @@ private:
 	int curr_time;
 	int max_time;
 	int actions_offset[5];
-	const vector<vector<int> > cons_paths;
-	const vector<int> my_heuristic;  // this is the precomputed heuristic for this agent
+	const PathReservations* reservations;  // paths of the agents planned before (e.g., delivering agents)
+	const vector<int>* my_heuristic;  // this is the precomputed heuristic for this agent (owned by its Endpoint)
+	std::unordered_set<uint64_t> vertex_cons;  // timestep*map_size+loc
+	std::unordered_set<uint64_t> edge_cons;  // (timestep*map_size+loc1)*map_size+loc2, the move starts at timestep
 };
 
 #endif
@@ -68,7 +68,7 @@ public:
 	Node(int loc, double g_val, double h_val, Node* parent, int timestep, int num_internal_conf = 0, bool in_openlist = false)
 		:loc(loc), g_val(g_val), h_val(h_val), parent(parent), timestep(timestep),
 		num_internal_conf(num_internal_conf), in_openlist(in_openlist) {}
-	Node::Node() : loc(0), g_val(0), h_val(0), parent(NULL), timestep(0), num_internal_conf(0), in_openlist(false) {}
+	Node() : loc(0), g_val(0), h_val(0), parent(NULL), timestep(0), num_internal_conf(0), in_openlist(false) {}
 	Node(const Node& other);
 	~Node();
 
@@ -3,22 +3,36 @@
 
 
 
+Simulation::Simulation()
+{
+}
 Simulation::Simulation(int num_agents, int num_tasks, int tasks_per_timestep)
 {
-
-	Kiva(20, 8, 10, num_agents, num_tasks, tasks_per_timestep);
+	vector<int> agent_counts;
+	for (int real_num_agents = 100; real_num_agents <= num_agents; real_num_agents += 100)
+		agent_counts.push_back(real_num_agents);
+	Kiva(20, 8, 10, agent_counts, num_tasks, tasks_per_timestep, 0, rand(), 0, "kiva");
 
 }
 Simulation::~Simulation()
 {
 }
 
-void Simulation::Kiva(int podRows, int podCols, int podLength, int num_agents, int num_tasks, int tasks_per_timestep) {
+//Writes one map per agent count (agents are placed on the same shuffled rest endpoints, so a map with fewer agents
+//keeps a subset of the agents of a larger one) and one task file shared by all of them.
+//Tasks arrive at tasks_per_timestep on average. burstiness = 0 spreads them evenly over timesteps, otherwise the
+//number of tasks of a timestep is drawn with variance mean + burstiness*mean^2 (gamma-Poisson).
+//maxtime = 0 uses the timestep of the last task + 5000.
+void Simulation::Kiva(int podRows, int podCols, int podLength, const vector<int> &agent_counts, int num_tasks,
+	double tasks_per_timestep, double burstiness, unsigned int seed, unsigned int maxtime, const string &prefix) {
 	const int sideWidth = 6;
+	std::mt19937 rng(seed);
+	int num_agents = *max_element(agent_counts.begin(), agent_counts.end());
 	row = 1 + 4 * podRows;
 	col = 2 * sideWidth + 1 + (1 + podLength) * podCols;
 	vector<char> cmap(row * col, '.');
 	vector<int> agt_endpoint_hashtable;
+	endpoint_hashtable.clear();
 
 	for (int i = 0; i < podRows; i++) {
 		int podR = 1 + 4 * i;
@@ -68,10 +82,42 @@ void Simulation::Kiva(int podRows, int podCols, int podLength, int num_agents, i
 		}
 	}
 
+	if (num_agents > (int)agt_endpoint_hashtable.size())
+		throw runtime_error("at most " + to_string(agt_endpoint_hashtable.size()) + " agents fit in " +
+			to_string(podRows) + " pod rows");
+	int num_workpoints = endpoint_hashtable.size() - num_agents;
+	if (num_workpoints < 2)
+		throw runtime_error("not enough endpoints for tasks");
+
+	//tasks (arrival timestep, start, goal), generated first since maxtime depends on the last arrival
+	vector<int> arrivals(num_tasks);
+	double expected = 0;
+	int time = -1, arrived = 0, due = 0;
+	std::gamma_distribution<double> burst(burstiness > 0 ? 1 / burstiness : 1, burstiness > 0 ? burstiness * tasks_per_timestep : 1);
+	for (int i = 0; i < num_tasks; i++) {
+		while (arrived == due) { //next timestep with tasks
+			time++;
+			arrived = 0;
+			if (burstiness > 0) {
+				std::poisson_distribution<int> count(burst(rng));
+				due = count(rng);
+			} else {
+				due = (int)(expected + tasks_per_timestep) - (int)expected;
+				expected += tasks_per_timestep;
+			}
+		}
+		arrivals[i] = time;
+		arrived++;
+	}
+	if (maxtime == 0)
+		maxtime = (num_tasks > 0 ? arrivals.back() : 0) + 5000;
+
 	string fname;
-	std::random_shuffle(agt_endpoint_hashtable.begin(), agt_endpoint_hashtable.end(), [](int n) { return rand() % n; });
+	std::shuffle(agt_endpoint_hashtable.begin(), agt_endpoint_hashtable.end(), rng);
+	string buffer;
 	
-	for (int real_num_agents = 100; real_num_agents <= num_agents; real_num_agents += 100) {
+	for (unsigned int a = 0; a < agent_counts.size(); a++) {
+		int real_num_agents = agent_counts[a];
 
 		for (int i = 0; i < real_num_agents; i++) {
 			cmap[agt_endpoint_hashtable[i]] = 'r';
@@ -80,48 +126,52 @@ void Simulation::Kiva(int podRows, int podCols, int podLength, int num_agents, i
 			cmap[agt_endpoint_hashtable[i]] = '.';
 		}
 
-		fname = "kiva-" + to_string(real_num_agents) + "-" + to_string(num_tasks) + "-" + to_string(tasks_per_timestep) + ".map";
+		fname = prefix + "-" + to_string(real_num_agents) + "-" + to_string(num_tasks) + "-" + FormatRate(tasks_per_timestep) + ".map";
 
-		std::ofstream fout(fname);
-		if (!fout) return;
+		std::ofstream fout(fname, ios::binary);
+		if (!fout) throw runtime_error("cannot write " + fname);
 
-		fout << row << "," << col << endl;
-		fout << endpoint_hashtable.size() - num_agents << endl;
-		//fout << endpoint_hashtable.size() << endl;
-		fout << real_num_agents << endl;
-		fout << 5000 << endl;
-		int index = 0;
+		buffer = to_string(row) + "," + to_string(col) + "\n";
+		buffer += to_string(num_workpoints) + "\n";
+		buffer += to_string(real_num_agents) + "\n";
+		buffer += to_string(maxtime) + "\n";
 		for (int i = 0; i < row; i++) {
-			for (int j = 0; j < col; j++) {
-				fout << cmap[index];
-				index++;
-			}
-			fout << std::endl;
+			buffer.append(cmap.begin() + i * col, cmap.begin() + (i + 1) * col);
+			buffer += '\n';
 		}
+		fout.write(buffer.data(), buffer.size());
 		fout.close();
 
 	}
 
 
-	fname = "kiva-" + to_string(num_agents) + "-" + to_string(num_tasks) + "-" + to_string(tasks_per_timestep) + ".task";
+	fname = prefix + "-" + to_string(num_agents) + "-" + to_string(num_tasks) + "-" + FormatRate(tasks_per_timestep) + ".task";
 
-	std::ofstream fout_tsk(fname);
-	if (!fout_tsk) return;
+	std::ofstream fout_tsk(fname, ios::binary);
+	if (!fout_tsk) throw runtime_error("cannot write " + fname);
 
-	fout_tsk << num_tasks << endl;
-
-	int time = -1;
+	std::uniform_int_distribution<int> endpoint(0, num_workpoints - 1);
+	buffer = to_string(num_tasks) + "\n";
 	for (int i = 0; i < num_tasks; i++) {
-		if (i%tasks_per_timestep == 0) {
-			time++;
-		}
-		int s = rand() % (endpoint_hashtable.size() - num_agents);
+		int s = endpoint(rng);
 		int g;
-		while ((g = rand() % (endpoint_hashtable.size() - num_agents)) == s){};
-		fout_tsk << time << " " << s << " " << g << " " << 0 << " " << 0 << endl;
+		while ((g = endpoint(rng)) == s){};
+		buffer += to_string(arrivals[i]) + " " + to_string(s) + " " + to_string(g) + " 0 0\n";
+		if (buffer.size() > (1 << 20)) { //write in chunks of ~1MB
+			fout_tsk.write(buffer.data(), buffer.size());
+			buffer.clear();
+		}
 	}
+	fout_tsk.write(buffer.data(), buffer.size());
 	fout_tsk.close();
 }
+//Rate as used in file names (50 -> "50", 2.5 -> "2.5")
+string Simulation::FormatRate(double rate)
+{
+	ostringstream ss;
+	ss << rate;
+	return ss.str();
+}
 
 void Simulation::LoadMap(string fname)
 {
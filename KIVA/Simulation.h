@@ -14,7 +14,8 @@ using namespace std;
 
 
 #include<boost/tokenizer.hpp>
-#include <dlib/optimization/max_cost_assignment.h>
+#include <random>
+#include <stdexcept>
 
 #include "Endpoint.h"
 #include "Agent.h"
@@ -27,10 +28,12 @@ class Simulation
 {
 public:
 
+	Simulation();
 	Simulation(int num_agents, int num_tasks, int tasks_per_timestep);
 	~Simulation();
 
-	void Kiva(int podRows, int podCols, int podLength, int numAgents, int num_tasks, int tasks_per_timestep);
+	void Kiva(int podRows, int podCols, int podLength, const vector<int> &agent_counts, int num_tasks,
+		double tasks_per_timestep, double burstiness, unsigned int seed, unsigned int maxtime, const string &prefix);
 	
 	//save
 	void ShowTask();
@@ -40,6 +43,7 @@ public:
 
 private:
 	// initialize
+	static string FormatRate(double rate);
 	void LoadMap(string fname);
 	void LoadTask(string fname);
 	
@@ -0,0 +1,73 @@
+#include "Simulation.h"
+#include <boost/program_options.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace po = boost::program_options;
+using namespace std;
+
+// Generates KIVA-like warehouse maps and tasks (same formats as Instances/)
+int main(int argc, char **argv) {
+  try {
+    po::options_description desc("Allowed options");
+
+    desc.add_options()("help", "produce help message")(
+        "pod-rows", po::value<int>()->default_value(20), "number of pod rows")(
+        "pod-cols", po::value<int>()->default_value(8),
+        "number of pods per row")(
+        "pod-length", po::value<int>()->default_value(10), "length of a pod")(
+        "agents,a",
+        po::value<vector<int>>()->multitoken()->default_value(
+            vector<int>(1, 500), "500"),
+        "number of agents, one map per value")(
+        "tasks,n", po::value<int>()->default_value(1000), "number of tasks")(
+        "rate,r", po::value<double>()->default_value(50),
+        "average number of tasks arriving per timestep")(
+        "burstiness,b", po::value<double>()->default_value(0),
+        "0 spreads tasks evenly, otherwise the variance of the tasks per "
+        "timestep is rate + burstiness * rate^2")(
+        "seed,s", po::value<unsigned int>()->default_value(0),
+        "random seed")("maxtime", po::value<unsigned int>()->default_value(0),
+                       "maxtime of the maps (0: last arrival + 5000)")(
+        "output,o", po::value<string>()->default_value("kiva"),
+        "prefix of the output files");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+
+    if (vm.count("help")) {
+      cout << desc << "\n";
+      return 0;
+    }
+
+    po::notify(vm);
+
+    const vector<int> &agents = vm["agents"].as<vector<int>>();
+    if (vm["pod-rows"].as<int>() < 1 || vm["pod-cols"].as<int>() < 1 ||
+        vm["pod-length"].as<int>() < 1)
+      throw runtime_error("the layout needs at least one pod");
+    for (unsigned int i = 0; i < agents.size(); i++)
+      if (agents[i] < 1)
+        throw runtime_error("agent counts must be positive");
+    if (vm["tasks"].as<int>() < 0 || vm["rate"].as<double>() <= 0 ||
+        vm["burstiness"].as<double>() < 0)
+      throw runtime_error("tasks must be >= 0, rate > 0 and burstiness >= 0");
+
+    Simulation simu;
+    simu.Kiva(vm["pod-rows"].as<int>(), vm["pod-cols"].as<int>(),
+              vm["pod-length"].as<int>(), agents, vm["tasks"].as<int>(),
+              vm["rate"].as<double>(), vm["burstiness"].as<double>(),
+              vm["seed"].as<unsigned int>(), vm["maxtime"].as<unsigned int>(),
+              vm["output"].as<string>());
+
+  } catch (exception &e) {
+    cerr << "Error: " << e.what() << "\n";
+    return 1;
+  } catch (...) {
+    cerr << "Unknown error!"
+         << "\n";
+    return 1;
+  }
+  return 0;
+}